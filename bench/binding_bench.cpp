@@ -0,0 +1,340 @@
+#include "quickjs.h"
+
+#include "atom_table.hpp"
+#include "binding.hpp"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* ns per call of every binding style of the demos, measured from a JS loop
+ * calling the binding CallsPerIteration times (JsLoop/baseline is the cost
+ * of the loop itself). Output is JSON unless --benchmark_format is given:
+ *
+ *   ./bench --benchmark_out=bench.json
+ */
+
+namespace {
+
+constexpr int CallsPerIteration = 1000;
+
+int Add(int a, int b) {
+    return a + b;
+}
+
+double Half(double value) {
+    return value * 0.5;
+}
+
+double Hypot(double x, double y) {
+    return std::sqrt(x * x + y * y);
+}
+
+struct Point {
+    double x;
+    double y;
+
+    Point(double x, double y) : x{x}, y{y} {}
+};
+
+/******************* hand written bindings (demos/04 ~ 06) *******************/
+
+JSValue AddFnBinding(JSContext* ctx, JSValueConst, int argc,
+                     JSValueConst* argv) {
+    if (argc < 2) {
+        return JS_ThrowTypeError(ctx, "expect 2 arguments");
+    }
+
+    int32_t a, b;
+    if (JS_ToInt32(ctx, &a, argv[0]) < 0 || JS_ToInt32(ctx, &b, argv[1]) < 0) {
+        return JS_EXCEPTION;
+    }
+    return JS_NewInt32(ctx, Add(a, b));
+}
+
+JSValue MagicBinding(JSContext* ctx, JSValueConst self, int argc,
+                     JSValueConst* argv, int magic) {
+    if (magic == 0) {
+        return AddFnBinding(ctx, self, argc, argv);
+    }
+    return JS_UNDEFINED;
+}
+
+JSClassID gPointClassID = 0;
+
+JSValue PointXGetter(JSContext* ctx, JSValueConst self) {
+    auto p = static_cast<Point*>(JS_GetOpaque2(ctx, self, gPointClassID));
+    return p ? JS_NewFloat64(ctx, p->x) : JS_EXCEPTION;
+}
+
+JSValue PointXSetter(JSContext* ctx, JSValueConst self, JSValueConst value) {
+    auto p = static_cast<Point*>(JS_GetOpaque2(ctx, self, gPointClassID));
+    if (!p || JS_ToFloat64(ctx, &p->x, value) < 0) {
+        return JS_EXCEPTION;
+    }
+    return JS_UNDEFINED;
+}
+
+JSValue PointConstructor(JSContext* ctx, JSValueConst, int argc,
+                         JSValueConst* argv) {
+    double x, y;
+    if (argc < 2 || JS_ToFloat64(ctx, &x, argv[0]) < 0 ||
+        JS_ToFloat64(ctx, &y, argv[1]) < 0) {
+        return JS_EXCEPTION;
+    }
+
+    JSValue result = JS_NewObjectClass(ctx, gPointClassID);
+    if (JS_IsException(result)) {
+        return result;
+    }
+    JS_SetOpaque(result, new Point(x, y));
+    return result;
+}
+
+const JSCFunctionListEntry gPointEntries[] = {
+    JS_CGETSET_DEF("x", PointXGetter, PointXSetter),
+};
+
+int BenchModuleInit(JSContext* ctx, JSModuleDef* m) {
+    return JS_SetModuleExport(ctx, m, "Add",
+                              JS_NewCFunction(ctx, AddFnBinding, "Add", 2));
+}
+
+/*********************** template bindings (demos/08~) ***********************/
+
+struct TPoint {
+    double x;
+    double y;
+
+    TPoint(double x, double y) : x{x}, y{y} {}
+};
+
+const JSCFunctionListEntry gTPointEntries[] = {
+    ClassBinder<TPoint>::Field<&TPoint::x>("x"),
+};
+
+/************************ bench environment ************************/
+
+bool DefineGlobal(JSContext* ctx, const char* name, JSValue value) {
+    JSValue global_this = JS_GetGlobalObject(ctx);
+    int result =
+        JS_DefinePropertyValueStr(ctx, global_this, name, value, JS_PROP_C_W_E);
+    JS_FreeValue(ctx, global_this);
+    return result >= 0;
+}
+
+bool RegisterPoint(JSRuntime* runtime, JSContext* ctx) {
+    JS_NewClassID(runtime, &gPointClassID);
+    JSClassDef def{};
+    def.class_name = "Point";
+    def.finalizer = +[](JSRuntime*, JSValue self) {
+        delete static_cast<Point*>(JS_GetOpaque(self, gPointClassID));
+    };
+    if (JS_NewClass(runtime, gPointClassID, &def) < 0) {
+        return false;
+    }
+
+    JSValue proto = JS_NewObject(ctx);
+    JS_SetPropertyFunctionList(ctx, proto, gPointEntries,
+                               std::size(gPointEntries));
+    JSValue constructor = JS_NewCFunction2(ctx, PointConstructor, "Point", 2,
+                                           JS_CFUNC_constructor, 0);
+    JS_SetConstructor(ctx, constructor, proto);
+    JS_SetClassProto(ctx, gPointClassID, proto);
+    return DefineGlobal(ctx, "Point", constructor);
+}
+
+// one runtime with every binding style registered
+class BenchEngine {
+public:
+    BenchEngine() {
+        m_runtime = JS_NewRuntime();
+        m_ctx = JS_NewContext(m_runtime);
+        m_ok = Register();
+    }
+
+    ~BenchEngine() {
+        JS_FreeValue(m_ctx, m_loop);
+        JS_FreeContext(m_ctx);
+        JS_FreeRuntime(m_runtime);
+    }
+
+    /* define `loop(n)` running body n times after setup, in module scope
+     * when is_module (so setup can import)
+     */
+    bool CompileLoop(const std::string& setup, const std::string& body,
+                     bool is_module) {
+        if (!m_ok) {
+            return false;
+        }
+
+        std::string code = setup + "\nglobalThis.loop = function (n) {\n" +
+                           "    for (let i = 0; i < n; i++) { " + body +
+                           " }\n};\n";
+        int flags = is_module ? JS_EVAL_TYPE_MODULE : JS_EVAL_TYPE_GLOBAL;
+        JSValue result =
+            JS_Eval(m_ctx, code.data(), code.size(), "<bench>", flags);
+        if (JS_IsException(result)) {
+            return false;
+        }
+        JS_FreeValue(m_ctx, result);
+
+        JSValue global_this = JS_GetGlobalObject(m_ctx);
+        m_loop = GetProperty<"loop">(m_ctx, global_this);
+        JS_FreeValue(m_ctx, global_this);
+        return JS_IsFunction(m_ctx, m_loop);
+    }
+
+    // false when loop throws
+    bool RunLoop(int n) {
+        JSValue arg = JS_NewInt32(m_ctx, n);
+        JSValue result = JS_Call(m_ctx, m_loop, JS_UNDEFINED, 1, &arg);
+        bool success = !JS_IsException(result);
+        JS_FreeValue(m_ctx, result);
+        return success;
+    }
+
+    std::string TakeError() {
+        JSValue exception = JS_GetException(m_ctx);
+        const char* str = JS_ToCString(m_ctx, exception);
+        std::string message = str ? str : "setup failed";
+        JS_FreeCString(m_ctx, str);
+        JS_FreeValue(m_ctx, exception);
+        return message;
+    }
+
+private:
+    JSRuntime* m_runtime;
+    JSContext* m_ctx;
+    JSValue m_loop = JS_UNDEFINED;
+    bool m_ok;
+
+    bool Register() {
+        JSContext* ctx = m_ctx;
+
+        // see BindFF/BindFFF in demos/04-BindingGlobalFunctions
+        JSCFunctionType half, hypot;
+        half.f_f = Half;
+        hypot.f_f_f = Hypot;
+
+        JSValue engine = JS_NewObject(ctx);
+        JS_SetPropertyStr(ctx, engine, "Add",
+                          JS_NewCFunctionMagic(ctx, MagicBinding, "Add", 2,
+                                               JS_CFUNC_generic_magic, 0));
+
+        JSModuleDef* module_def =
+            JS_NewCModule(ctx, "bench", BenchModuleInit);
+        if (!module_def || JS_AddModuleExport(ctx, module_def, "Add") < 0) {
+            return false;
+        }
+
+        JSValue tpoint = ClassBinder<TPoint>::Register<double, double>(
+            m_runtime, ctx, "TPoint", gTPointEntries,
+            std::size(gTPointEntries));
+        if (JS_IsException(tpoint)) {
+            return false;
+        }
+
+        return DefineGlobal(ctx, "Add",
+                            JS_NewCFunction(ctx, AddFnBinding, "Add", 2)) &&
+               DefineGlobal(ctx, "Engine", engine) &&
+               DefineGlobal(ctx, "Half",
+                            JS_NewCFunction2(ctx, half.generic, "Half", 1,
+                                             JS_CFUNC_f_f, 0)) &&
+               DefineGlobal(ctx, "Hypot",
+                            JS_NewCFunction2(ctx, hypot.generic, "Hypot", 2,
+                                             JS_CFUNC_f_f_f, 0)) &&
+               RegisterPoint(m_runtime, ctx) &&
+               BindFunction<Add>(ctx, "TAdd") &&
+               DefineGlobal(ctx, "TPoint", tpoint);
+    }
+};
+
+/* items: work items per loop iteration of script (batch calls process
+ * many elements at once), ns_per_call is reported per item
+ */
+void BenchLoop(benchmark::State& state, const char* setup, const char* body,
+               bool is_module, int items) {
+    BenchEngine engine;
+    if (!engine.CompileLoop(setup, body, is_module)) {
+        state.SkipWithError(engine.TakeError().c_str());
+        return;
+    }
+
+    int loop_count = CallsPerIteration / items;
+    for (auto _ : state) {
+        if (!engine.RunLoop(loop_count)) {
+            state.SkipWithError(engine.TakeError().c_str());
+            break;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * loop_count * items);
+    // inverted rate of 1e-9 item per iteration: ns per item
+    state.counters["ns_per_call"] = benchmark::Counter(
+        loop_count * items * 1e-9,
+        benchmark::Counter::kIsIterationInvariantRate |
+            benchmark::Counter::kInvert);
+}
+
+void JsLoop(benchmark::State& state, const char* setup, const char* body) {
+    BenchLoop(state, setup, body, false, 1);
+}
+
+void ModuleLoop(benchmark::State& state, const char* setup, const char* body) {
+    BenchLoop(state, setup, body, true, 1);
+}
+
+void BatchLoop(benchmark::State& state, const char* setup, const char* body) {
+    BenchLoop(state, setup, body, false, CallsPerIteration);
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(JsLoop, baseline, "", "");
+BENCHMARK_CAPTURE(JsLoop, c_function, "", "Add(i, 1)");
+BENCHMARK_CAPTURE(JsLoop, magic_function, "", "Engine.Add(i, 1)");
+BENCHMARK_CAPTURE(JsLoop, cfunc_f_f, "", "Half(i)");
+BENCHMARK_CAPTURE(JsLoop, cfunc_f_f_f, "", "Hypot(i, 1)");
+BENCHMARK_CAPTURE(JsLoop, cgetset_getter, "globalThis.p = new Point(1, 2)",
+                  "p.x");
+BENCHMARK_CAPTURE(JsLoop, cgetset_setter, "globalThis.p = new Point(1, 2)",
+                  "p.x = i");
+BENCHMARK_CAPTURE(JsLoop, class_construct_finalize, "", "new Point(i, 1)");
+BENCHMARK_CAPTURE(ModuleLoop, module_function,
+                  "import { Add as ModAdd } from 'bench'", "ModAdd(i, 1)");
+BENCHMARK_CAPTURE(JsLoop, template_function, "", "TAdd(i, 1)");
+BENCHMARK_CAPTURE(JsLoop, template_field_getter,
+                  "globalThis.p = new TPoint(1, 2)", "p.x");
+BENCHMARK_CAPTURE(JsLoop, template_field_setter,
+                  "globalThis.p = new TPoint(1, 2)", "p.x = i");
+BENCHMARK_CAPTURE(JsLoop, template_construct_finalize, "",
+                  "new TPoint(i, 1)");
+BENCHMARK_CAPTURE(BatchLoop, template_batch,
+                  "globalThis.a = new Int32Array(1000).fill(1);"
+                  "globalThis.out = new Int32Array(1000)",
+                  "TAdd.batch(a, a, out)");
+
+int main(int argc, char** argv) {
+    // JSON by default, so results can be tracked by tools
+    std::vector<char*> args(argv, argv + argc);
+    bool has_format = false;
+    for (int i = 1; i < argc; i++) {
+        has_format |= std::string_view{argv[i]}.starts_with(
+            "--benchmark_format");
+    }
+    static char json_format[] = "--benchmark_format=json";
+    if (!has_format) {
+        args.insert(args.begin() + 1, json_format);
+    }
+
+    int bench_argc = static_cast<int>(args.size());
+    benchmark::Initialize(&bench_argc, args.data());
+    if (benchmark::ReportUnrecognizedArguments(bench_argc, args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
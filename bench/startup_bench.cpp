@@ -0,0 +1,342 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include "binding.hpp"
+#include "common.hpp"
+#include "runtime_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+/* time every phase of the demos' startup over many iterations and print
+ * percentiles (microseconds) & memory per runtime as JSON:
+ *
+ *   ./startup_bench [iterations]
+ *
+ * pool_acquire_release is the cost of a request served by RuntimePool
+ * instead of the cold startup above it
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum Phase {
+    NewRuntime,
+    NewContext,
+    InitHandlers,
+    AddHelpers,
+    InitModules,
+    BindClass,
+    EvalSource,
+    LoadBytecode,
+    FreeRuntime,
+    Total,
+    PoolAcquireRelease,
+    PhaseCount,
+};
+
+const char* const PhaseNames[PhaseCount] = {
+    "new_runtime",
+    "new_context",
+    "std_init_handlers",
+    "std_add_helpers",
+    "init_modules",
+    "bind_class",
+    "eval_source",
+    "load_bytecode",
+    "free_runtime",
+    "total",
+    "pool_acquire_release",
+};
+
+// runtimes alive at once when measuring RSS per runtime
+constexpr int HeldRuntimes = 100;
+
+const char Source[] = R"(
+function fib(n) {
+    return n < 2 ? n : fib(n - 1) + fib(n - 2)
+}
+var people = []
+for (var i = 0; i < 10; i++) {
+    people.push(new Person("person" + i, 20 + i))
+}
+fib(10)
+)";
+
+struct Person {
+    std::string name;
+    int age;
+
+    Person(const std::string& name, int age) : name{name}, age{age} {}
+};
+
+// This lifetime must longer than script JSValue
+const JSCFunctionListEntry gPersonEntries[] = {
+    ClassBinder<Person>::Field<&Person::name>("name"),
+    ClassBinder<Person>::Field<&Person::age>("age"),
+};
+
+bool InitRuntime(JSRuntime* runtime) {
+    js_std_init_handlers(runtime);
+    return true;
+}
+
+bool BindPerson(JSRuntime* runtime, JSContext* ctx) {
+    JSValue constructor = ClassBinder<Person>::Register<std::string, int>(
+        runtime, ctx, "Person", gPersonEntries, std::size(gPersonEntries));
+    if (JS_IsException(constructor)) {
+        return false;
+    }
+
+    JSValue global_this = JS_GetGlobalObject(ctx);
+    int result = JS_DefinePropertyValueStr(ctx, global_this, "Person",
+                                           constructor, JS_PROP_C_W_E);
+    JS_FreeValue(ctx, global_this);
+    return result >= 0;
+}
+
+bool InitContext(JSRuntime* runtime, JSContext* ctx) {
+    js_std_add_helpers(ctx, 0, NULL);
+    js_init_module_std(ctx, "std");
+    js_init_module_os(ctx, "os");
+    js_init_module_bjson(ctx, "bjson");
+    return BindPerson(runtime, ctx);
+}
+
+void FreeHandlers(JSRuntime* runtime) {
+    js_std_free_handlers(runtime);
+}
+
+struct Instance {
+    JSRuntime* runtime = nullptr;
+    JSContext* ctx = nullptr;
+};
+
+// phase durations of one startup, in microseconds
+using Sample = std::array<double, PhaseCount>;
+
+class Lap {
+public:
+    // elapsed time since last call
+    double operator()() {
+        Clock::time_point now = Clock::now();
+        double us =
+            std::chrono::duration<double, std::micro>(now - m_last).count();
+        m_last = now;
+        return us;
+    }
+
+private:
+    Clock::time_point m_last = Clock::now();
+};
+
+// do what demos do in main(), timing each step
+Instance Startup(const std::string& bytecode_file, Sample& sample) {
+    Instance instance;
+    Lap lap;
+
+    instance.runtime = JS_NewRuntime();
+    sample[NewRuntime] = lap();
+
+    instance.ctx = JS_NewContext(instance.runtime);
+    sample[NewContext] = lap();
+
+    InitRuntime(instance.runtime);
+    sample[InitHandlers] = lap();
+
+    js_std_add_helpers(instance.ctx, 0, NULL);
+    sample[AddHelpers] = lap();
+
+    js_init_module_std(instance.ctx, "std");
+    js_init_module_os(instance.ctx, "os");
+    js_init_module_bjson(instance.ctx, "bjson");
+    sample[InitModules] = lap();
+
+    BindPerson(instance.runtime, instance.ctx);
+    sample[BindClass] = lap();
+
+    JSValue result = JS_Eval(instance.ctx, Source, sizeof(Source) - 1,
+                             "<startup>", JS_EVAL_TYPE_GLOBAL);
+    CheckJSValue(instance.ctx, result);
+    JS_FreeValue(instance.ctx, result);
+    sample[EvalSource] = lap();
+
+    ExecuteBinaryScript(instance.ctx, bytecode_file);
+    sample[LoadBytecode] = lap();
+    return instance;
+}
+
+void Shutdown(Instance instance) {
+    JS_FreeContext(instance.ctx);
+    FreeHandlers(instance.runtime);
+    JS_FreeRuntime(instance.runtime);
+}
+
+// compile Source once, ExecuteBinaryScript load it like demos/07
+bool WriteBytecode(const std::string& filename) {
+    JSRuntime* runtime = JS_NewRuntime();
+    JSContext* ctx = JS_NewContext(runtime);
+    JSValue obj = JS_Eval(ctx, Source, sizeof(Source) - 1, "<startup>",
+                          JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+    bool success = false;
+    if (!JS_IsException(obj)) {
+        size_t size;
+        uint8_t* data = JS_WriteObject(ctx, &size, obj, JS_WRITE_OBJ_BYTECODE);
+        if (data) {
+            std::ofstream file{filename, std::ios::binary};
+            file.write(reinterpret_cast<const char*>(data), size);
+            success = file.good();
+            js_free(ctx, data);
+        }
+    }
+    JS_FreeValue(ctx, obj);
+    JS_FreeContext(ctx);
+    JS_FreeRuntime(runtime);
+    return success;
+}
+
+// resident set size of process, 0 when unknown
+size_t CurrentRSS() {
+#ifdef __linux__
+    std::ifstream statm{"/proc/self/statm"};
+    size_t total_pages, resident_pages;
+    if (statm >> total_pages >> resident_pages) {
+        return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+#endif
+    return 0;
+}
+
+size_t PeakRSS() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);  // bytes
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;  // kilobytes
+#endif
+#endif
+}
+
+// print {"mean":..,"p50":..,...} of samples
+void PrintStats(std::vector<double>& samples) {
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        size_t index = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+        return samples[index];
+    };
+    double mean = std::accumulate(samples.begin(), samples.end(), 0.0) /
+                  samples.size();
+    std::cout << "{\"mean\": " << mean << ", \"p50\": " << percentile(0.5)
+              << ", \"p90\": " << percentile(0.9)
+              << ", \"p99\": " << percentile(0.99)
+              << ", \"max\": " << samples.back() << "}";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+    if (iterations <= 0) {
+        std::cerr << "usage: startup_bench [iterations]" << std::endl;
+        return 1;
+    }
+
+    std::string bytecode_file =
+        (std::filesystem::temp_directory_path() / "startup_bench.qjs")
+            .string();
+    if (!WriteBytecode(bytecode_file)) {
+        std::cerr << "write bytecode failed" << std::endl;
+        return 2;
+    }
+
+    std::vector<std::vector<double>> samples(PhaseCount);
+    for (auto& phase_samples : samples) {
+        phase_samples.reserve(iterations);
+    }
+
+    size_t runtime_malloc_bytes = 0;
+    for (int i = 0; i < iterations; i++) {
+        Sample sample{};
+        Lap total;
+        Instance instance = Startup(bytecode_file, sample);
+        if (i == 0) {
+            JSMemoryUsage usage;
+            JS_ComputeMemoryUsage(instance.runtime, &usage);
+            runtime_malloc_bytes = static_cast<size_t>(usage.malloc_size);
+        }
+
+        Lap lap;
+        Shutdown(instance);
+        sample[FreeRuntime] = lap();
+        sample[Total] = total();
+
+        for (int phase = 0; phase < PoolAcquireRelease; phase++) {
+            samples[phase].push_back(sample[phase]);
+        }
+    }
+
+    {
+        RuntimePoolOptions options;
+        options.capacity = 1;
+        options.init_runtime = InitRuntime;
+        options.init_context = InitContext;
+        options.free_runtime = FreeHandlers;
+        RuntimePool pool{std::move(options)};
+        for (int i = 0; i < iterations; i++) {
+            Lap lap;
+            {
+                // context is recreated in background after lease is back
+                RuntimeLease lease = pool.Acquire();
+            }
+            samples[PoolAcquireRelease].push_back(lap());
+        }
+    }
+
+    // RSS growth of holding many initialized runtimes at once
+    size_t rss_before = CurrentRSS();
+    std::vector<Instance> held;
+    for (int i = 0; i < HeldRuntimes; i++) {
+        Sample sample{};
+        held.push_back(Startup(bytecode_file, sample));
+    }
+    size_t rss_after = CurrentRSS();
+    for (Instance instance : held) {
+        Shutdown(instance);
+    }
+    size_t rss_per_runtime =
+        rss_after > rss_before ? (rss_after - rss_before) / HeldRuntimes : 0;
+
+    std::filesystem::remove(bytecode_file);
+
+    std::cout << "{\n  \"iterations\": " << iterations
+              << ",\n  \"phases_us\": {\n";
+    for (int phase = 0; phase < PhaseCount; phase++) {
+        std::cout << "    \"" << PhaseNames[phase] << "\": ";
+        PrintStats(samples[phase]);
+        std::cout << (phase + 1 < PhaseCount ? ",\n" : "\n");
+    }
+    std::cout << "  },\n  \"runtime_malloc_bytes\": " << runtime_malloc_bytes
+              << ",\n  \"rss_bytes_per_runtime\": " << rss_per_runtime
+              << ",\n  \"peak_rss_bytes\": " << PeakRSS() << "\n}"
+              << std::endl;
+    return 0;
+}
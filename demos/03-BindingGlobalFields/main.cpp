@@ -57,6 +57,7 @@ void BindConst(JSContext* ctx) {
 
     // or you can use JS_DefinePropertyValue, the difference is it need a JSAtom
     // as name JSAtom aime to reuse name(deduce string copy)
+    // (Atom<"name">(ctx) in atom_table.hpp keep it for the whole runtime)
     JSAtom name = JS_NewAtom(ctx, "const_global_var3");
     JS_DefinePropertyValue(ctx, global_this, name, new_obj, JS_PROP_ENUMERABLE);
     JS_FreeAtom(ctx, name);
@@ -2,6 +2,7 @@
 #include "quickjs.h"
 
 #include <iostream>
+#include "bytecode_cache.hpp"
 #include "common.hpp"
 
 int Add(int a, int b) {
@@ -145,6 +146,9 @@ int main() {
     BindFF(ctx);
     BindFFF(ctx);
 
+    // [optional] keep compiled main.js between runs, next run skip parsing
+    BytecodeCache::Instance().SetDirectory(".qjs-cache");
+
     std::cout << "-------------non strict mode---------------" << std::endl;
     ExecuteScript(ctx, "demos/04-BindingGlobalFunctions/main.js", 0);
 
@@ -2,6 +2,7 @@
 #include "quickjs.h"
 
 #include "common.hpp"
+#include "memory_telemetry.hpp"
 
 struct Person {
     static int ID;
@@ -53,6 +54,13 @@ JSValue NameSetter(JSContext* ctx, JSValue self, JSValueConst param) {
     return JS_UNDEFINED;
 }
 
+// live Person count & bytes for MemoryTelemetry (ClassBinder does it itself)
+NativeClassCounter& PersonCounter() {
+    static NativeClassCounter& counter =
+        NativeClassCounter::Get("Person", sizeof(Person));
+    return counter;
+}
+
 JSValue ConstructorBinding(JSContext* ctx, JSValue self, int argc,
                            JSValueConst* argv) {
     // I'm lazy to check argv type :-)
@@ -68,6 +76,7 @@ JSValue ConstructorBinding(JSContext* ctx, JSValue self, int argc,
     JSValue result = JS_NewObjectClass(ctx, gClassID);
     CheckJSValue(ctx, result);
     QJS_CALL(JS_SetOpaque(result, person));
+    PersonCounter().Add();
     return result;
 }
 
@@ -115,6 +124,9 @@ void BindClass(JSRuntime* runtime, JSContext* ctx) {
             std::cerr << "self is nullptr" << std::endl;
         }
 
+        if (opaque) {
+            PersonCounter().Remove();
+        }
         delete opaque;
     };
     def.class_name = class_name;
@@ -2,30 +2,9 @@
 #include "quickjs.h"
 
 #include <iostream>
-#include <sstream>
-#include <fstream>
 
 #include "common.hpp"
 
-void ExecuteBinaryScript(JSContext* ctx, const std::string& filename, int flags) {
-    std::ifstream file(filename, std::ios::in | std::ios::binary);
-    if (!file) {
-        std::cerr << "open file main.js failed" << std::endl;
-    }
-    std::stringstream ss;
-    ss << file.rdbuf();
-    std::string content = ss.str();
-
-    JSValue obj = JS_ReadObject(ctx, (uint8_t*)content.data(), content.size(), JS_READ_OBJ_BYTECODE);
-    CheckJSValue(ctx, obj);
-
-    JSValue result = JS_EvalFunction(ctx, obj);
-    CheckJSValue(ctx, result);
-
-    JS_FreeValue(ctx, obj);
-    JS_FreeValue(ctx, result);
-}
-
 int main() {
     JSRuntime* runtime = JS_NewRuntime();
     if (!runtime) {
@@ -47,7 +26,8 @@ int main() {
 
     js_init_module_std(ctx, "std");
 
-    ExecuteBinaryScript(ctx, "demos/07-RunBytecode/output.qjs", JS_EVAL_TYPE_MODULE);
+    // bytecode file is memory mapped and fed to JS_ReadObject directly
+    ExecuteBinaryScript(ctx, "demos/07-RunBytecode/output.qjs");
 
     js_std_loop(ctx);
 
@@ -0,0 +1,120 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include <cmath>
+
+#include "binding.hpp"
+#include "common.hpp"
+#include "embedded_scripts.hpp"
+
+int Add(int a, int b) {
+    return a + b;
+}
+
+double Lerp(double a, double b, double t) {
+    return a + (b - a) * t;
+}
+
+std::string Greet(std::string_view name) {
+    return "Hello " + std::string{name};
+}
+
+void Log(const std::string& msg) {
+    std::cout << "[native] " << msg << std::endl;
+}
+
+bool IsEven(int64_t value) {
+    return value % 2 == 0;
+}
+
+double Hypot(double x, double y) {
+    return std::sqrt(x * x + y * y);
+}
+
+float Half(float value) {
+    return value * 0.5f;
+}
+
+void MagicFn1() {
+    std::cout << "I'm magicFn1" << std::endl;
+}
+
+void MagicFn2() {
+    std::cout << "I'm magicFn2" << std::endl;
+}
+
+int Mul(int a, int b) {
+    return a * b;
+}
+
+// all functions share one JSCFunctionMagic, magic is index of jump table
+using EngineFns = MagicFunctionTable<&MagicFn1, &MagicFn2, &Mul>;
+
+// This lifetime must longer than script JSValue
+const auto gEngineEntries =
+    EngineFns::MakeEntries({"MagicFn1", "MagicFn2", "Mul"});
+
+void Bind(JSContext* ctx) {
+    /* BindFunction deduce parameter & return types from function signature
+     * and generate a thunk for it, compare with AddFnBinding in
+     * demos/04-BindingGlobalFunctions
+     */
+    if (!BindFunction<&Add>(ctx, "Add") || !BindFunction<&Lerp>(ctx, "Lerp") ||
+        !BindFunction<&Greet>(ctx, "Greet") ||
+        !BindFunction<&Log>(ctx, "Log") ||
+        !BindFunction<&IsEven>(ctx, "IsEven")) {
+        js_std_dump_error(ctx);
+    }
+
+    /* pure floating point functions are registered as JS_CFUNC_f_f and
+     * JS_CFUNC_f_f_f automatically (compare with BindFF/BindFFF in
+     * demos/04-BindingGlobalFunctions), captureless lambda also works
+     */
+    if (!BindFunction<&Hypot>(ctx, "Hypot") ||
+        !BindFunction<&Half>(ctx, "Half") ||
+        !BindFunction<[](double x) { return x * x; }>(ctx, "Square")) {
+        js_std_dump_error(ctx);
+    }
+
+    // bulk register functions to `Engine` object by one function list
+    JSValue global_this = JS_GetGlobalObject(ctx);
+    JSValue engine = JS_NewObject(ctx);
+    CheckJSValue(ctx, engine);
+    QJS_CALL(JS_SetPropertyFunctionList(ctx, engine, gEngineEntries.data(),
+                                        gEngineEntries.size()));
+    QJS_CALL(JS_DefinePropertyValueStr(ctx, global_this, "Engine", engine,
+                                       JS_PROP_C_W_E));
+    JS_FreeValue(ctx, global_this);
+}
+
+int main() {
+    JSRuntime* runtime = JS_NewRuntime();
+    if (!runtime) {
+        std::cerr << "init runtime failed" << std::endl;
+        return 1;
+    }
+
+    JSContext* ctx = JS_NewContext(runtime);
+    if (!ctx) {
+        std::cerr << "create context failed" << std::endl;
+        JS_FreeRuntime(runtime);
+        return 2;
+    }
+
+    // must first add runtime handler
+    js_std_init_handlers(runtime);
+
+    js_std_add_helpers(ctx, 0, NULL);
+
+    Bind(ctx);
+
+    ExecuteEmbeddedScript(ctx, "main.js");
+
+    JS_FreeContext(ctx);
+
+    // don't forget free handlers
+    js_std_free_handlers(runtime);
+
+    JS_FreeRuntime(runtime);
+    return 0;
+}
@@ -0,0 +1,33 @@
+"use strict"
+
+function main() {
+    console.log("Add(1, 2) = ", Add(1, 2))
+    console.log("Lerp(0, 10, 0.25) = ", Lerp(0, 10, 0.25))
+    console.log(Greet("QJSKid"))
+    Log("called from js")
+    console.log("IsEven(42) = ", IsEven(42))
+    console.log("Hypot(3, 4) = ", Hypot(3, 4))
+    console.log("Half(3) = ", Half(3))
+    console.log("Square(1.5) = ", Square(1.5))
+    Engine.MagicFn1()
+    Engine.MagicFn2()
+    console.log("Engine.Mul(6, 7) = ", Engine.Mul(6, 7))
+
+    // one native call for the whole array instead of one per element
+    const a = new Int32Array([1, 2, 3, 4])
+    const b = new Int32Array([10, 20, 30, 40])
+    console.log("Add.batch(a, b, out) = ", Add.batch(a, b, new Int32Array(4)))
+    const t = new Float64Array([0, 0.5, 1])
+    const lerped = Lerp.batch(new Float64Array(3), new Float64Array(3).fill(10),
+                              t, new Float64Array(3))
+    console.log("Lerp.batch(0, 10, t, out) = ", lerped)
+
+    try {
+        // will throw TypeError: expect 2 arguments but got 1
+        Add(1)
+    } catch (e) {
+        console.log(e)
+    }
+}
+
+main()
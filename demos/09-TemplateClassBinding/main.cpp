@@ -0,0 +1,114 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include "binding.hpp"
+#include "common.hpp"
+#include "embedded_scripts.hpp"
+
+struct Person {
+    static int ID;
+
+    char name[512] = {0};
+    float height;
+    float weight;
+    int age;
+
+    Person(const std::string& name, float height, int age, float weight)
+        : height{height}, weight{weight}, age{age} {
+        ChangeName(name);
+    }
+
+    void Introduce() const {
+        std::cout << "I am " << name << ", age " << age << ", height " << height
+                  << ", weight " << weight << std::endl;
+    }
+
+    float GetBMI() const { return weight / (height * height); }
+
+    void ChangeName(const std::string& name) {
+        strcpy(this->name, name.data());
+    }
+};
+
+int Person::ID = 1;
+
+// script create/drop many Person, allocate them from pool rather than heap
+template <>
+struct ClassAllocator<Person> : PoolClassAllocator<Person> {};
+
+using PersonBinder = ClassBinder<Person>;
+
+// This lifetime must longer than script JSValue
+const JSCFunctionListEntry entries[] = {
+    // bind member function
+    PersonBinder::Method<&Person::Introduce>("introduce"),
+    PersonBinder::Method<&Person::ChangeName>("changeName"),
+
+    // getter&setter read/write the field directly
+    PersonBinder::Field<&Person::name>("name"),
+    PersonBinder::Field<&Person::height>("height"),
+    PersonBinder::Field<&Person::weight>("weight"),
+    PersonBinder::Field<&Person::age>("age"),
+
+    // define member varaible by getter
+    PersonBinder::Property<&Person::GetBMI>("bmi"),
+};
+
+void BindClass(JSRuntime* runtime, JSContext* ctx) {
+    JSValue constructor =
+        PersonBinder::Register<std::string, float, int, float>(
+            runtime, ctx, "Person", entries, std::size(entries));
+    if (JS_IsException(constructor)) {
+        js_std_dump_error(ctx);
+        return;
+    }
+
+    // global field directly register to constructor rather than proto
+    JSValue id_value = JS_NewInt32(ctx, Person::ID);
+    QJS_CALL(JS_SetPropertyStr(ctx, constructor, "ID", id_value));
+
+    JSValue global_var = JS_GetGlobalObject(ctx);
+    QJS_CALL(JS_DefinePropertyValueStr(ctx, global_var, "Person", constructor,
+                                       JS_PROP_C_W_E));
+
+    JS_FreeValue(ctx, global_var);
+}
+
+int main() {
+    JSRuntime* runtime = JS_NewRuntime();
+    if (!runtime) {
+        std::cerr << "init runtime failed" << std::endl;
+        return 1;
+    }
+
+    JSContext* ctx = JS_NewContext(runtime);
+    if (!ctx) {
+        std::cerr << "create context failed" << std::endl;
+        JS_FreeRuntime(runtime);
+        return 2;
+    }
+
+    // must first add runtime handler
+    js_std_init_handlers(runtime);
+
+    js_std_add_helpers(ctx, 0, NULL);
+
+    BindClass(runtime, ctx);
+
+    ExecuteEmbeddedScript(ctx, "main.js");
+
+    // dropped Person are given back to pool when GC finalize them
+    JS_RunGC(runtime);
+    PoolStats stats = PoolClassAllocator<Person>::Stats();
+    std::cout << "Person pool: " << stats.in_use << "/" << stats.capacity
+              << " slots in use, " << stats.chunk_count << " chunks"
+              << std::endl;
+
+    JS_FreeContext(ctx);
+
+    // don't forget free handlers
+    js_std_free_handlers(runtime);
+
+    JS_FreeRuntime(runtime);
+    return 0;
+}
@@ -0,0 +1,35 @@
+"use strict"
+
+function main() {
+    let person = new Person("QJSKid", 1.5, 15, 40)
+    console.log(person.name)
+    person.name = "John"
+    console.log(person.name)
+    person.changeName("Tom")
+    console.log(person.name)
+
+    person.age += 1
+    person.height = 1.6
+    console.log("age: ", person.age, ", height: ", person.height)
+    console.log("bmi: ", person.bmi)
+    person.introduce()
+
+    console.log(Person.ID)
+    console.log(person instanceof Person)
+
+    try {
+        // will throw TypeError: bmi is read-only
+        person.bmi = 12
+    } catch (e) {
+        console.log(e)
+    }
+
+    // temporary objects are recycled by Person's pool
+    let total_age = 0
+    for (let i = 0; i < 10000; i++) {
+        total_age += new Person("Temp", 1.7, i % 100, 60).age
+    }
+    console.log("total age: ", total_age)
+}
+
+main()
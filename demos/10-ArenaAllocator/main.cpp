@@ -0,0 +1,53 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include "arena_allocator.hpp"
+#include "common.hpp"
+#include "embedded_scripts.hpp"
+
+void PrintStats(const ArenaStats& stats) {
+    std::cout << "reserved: " << stats.reserved_bytes
+              << ", used: " << stats.used_bytes
+              << ", peak: " << stats.peak_used_bytes
+              << ", allocations: " << stats.alloc_count
+              << ", failed: " << stats.failed_count << std::endl;
+}
+
+int main() {
+    // every allocation of runtime comes from arena, at most 8MB
+    RuntimeArena arena{8 * 1024 * 1024};
+
+    // short-lived runtimes reuse the same arena one by one
+    for (int i = 0; i < 3; i++) {
+        JSRuntime* runtime = NewRuntimeWithAllocator(arena);
+        if (!runtime) {
+            std::cerr << "init runtime failed" << std::endl;
+            return 1;
+        }
+
+        JSContext* ctx = JS_NewContext(runtime);
+        if (!ctx) {
+            std::cerr << "create context failed" << std::endl;
+            arena.ReleaseRuntime(runtime);
+            return 2;
+        }
+
+        // must first add runtime handler
+        js_std_init_handlers(runtime);
+
+        js_std_add_helpers(ctx, 0, NULL);
+
+        ExecuteEmbeddedScript(ctx, "main.js");
+        PrintStats(arena.Stats());
+
+        JS_FreeContext(ctx);
+
+        // don't forget free handlers
+        js_std_free_handlers(runtime);
+
+        // objects are not freed one by one, arena drop all its blocks
+        arena.ReleaseRuntime(runtime);
+    }
+
+    return 0;
+}
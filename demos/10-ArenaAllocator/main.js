@@ -0,0 +1,19 @@
+"use strict"
+
+function main() {
+    let points = []
+    for (let i = 0; i < 10000; i++) {
+        points.push({ x: i, y: i * 2 })
+    }
+    console.log("create points: ", points.length)
+
+    try {
+        // exceed arena's memory limit
+        let huge = new Array(16 * 1024 * 1024).fill(0)
+        console.log(huge.length)
+    } catch (e) {
+        console.log(e)
+    }
+}
+
+main()
@@ -0,0 +1,84 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include "binding.hpp"
+#include "common.hpp"
+#include "embedded_scripts.hpp"
+#include "runtime_pool.hpp"
+
+struct Counter {
+    int value = 0;
+
+    void Increase() { value++; }
+};
+
+// This lifetime must longer than script JSValue
+const JSCFunctionListEntry entries[] = {
+    ClassBinder<Counter>::Field<&Counter::value>("value"),
+    ClassBinder<Counter>::Method<&Counter::Increase>("increase"),
+};
+
+int Add(int a, int b) {
+    return a + b;
+}
+
+bool InitContext(JSRuntime* runtime, JSContext* ctx) {
+    js_std_add_helpers(ctx, 0, NULL);
+
+    if (!BindFunction<&Add>(ctx, "Add")) {
+        return false;
+    }
+
+    JSValue constructor = ClassBinder<Counter>::Register(
+        runtime, ctx, "Counter", entries, std::size(entries));
+    if (JS_IsException(constructor)) {
+        return false;
+    }
+
+    JSValue global_var = JS_GetGlobalObject(ctx);
+    int ret = JS_DefinePropertyValueStr(ctx, global_var, "Counter",
+                                        constructor, JS_PROP_C_W_E);
+    JS_FreeValue(ctx, global_var);
+    return ret >= 0;
+}
+
+int main() {
+    RuntimePoolOptions options;
+    options.capacity = 2;
+    // must first add runtime handler
+    options.init_runtime = [](JSRuntime* runtime) {
+        js_std_init_handlers(runtime);
+        return true;
+    };
+    options.init_context = InitContext;
+    // don't forget free handlers
+    options.free_runtime = js_std_free_handlers;
+
+    // runtimes are initialized here, out of "request" path
+    RuntimePool pool{options};
+
+    for (int request = 0; request < 4; request++) {
+        RuntimeLease lease = pool.Acquire();
+        if (!lease) {
+            std::cerr << "acquire runtime failed" << std::endl;
+            return 1;
+        }
+
+        ExecuteEmbeddedScript(lease.GetContext(), "main.js");
+        js_std_loop(lease.GetContext());
+
+        // lease is given back here, it gets a fresh context in background
+    }
+
+    // keep two leases at the same time, the third one is created on demand
+    {
+        RuntimeLease lease1 = pool.Acquire();
+        RuntimeLease lease2 = pool.Acquire();
+        RuntimeLease lease3 = pool.Acquire();
+    }
+
+    RuntimePoolStats stats = pool.Stats();
+    std::cout << "idle: " << stats.idle << ", warm: " << stats.warm_acquired
+              << ", cold: " << stats.cold_acquired << std::endl;
+    return 0;
+}
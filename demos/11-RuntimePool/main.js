@@ -0,0 +1,15 @@
+"use strict"
+
+function main() {
+    // each request see a clean global, previous `visited` is gone
+    console.log("visited before: ", typeof visited !== "undefined")
+    globalThis.visited = true
+
+    let counter = new Counter()
+    for (let i = 0; i < 3; i++) {
+        counter.increase()
+    }
+    console.log("counter: ", counter.value, ", Add(1, 2) = ", Add(1, 2))
+}
+
+main()
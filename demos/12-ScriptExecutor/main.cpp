@@ -0,0 +1,53 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include "common.hpp"
+#include "embedded_scripts.hpp"
+#include "script_executor.hpp"
+
+int main() {
+    ExecutorOptions options;
+    options.worker_count = 4;
+    options.init_context = [](JSRuntime*, JSContext* ctx) {
+        js_std_add_helpers(ctx, 0, NULL);
+        return true;
+    };
+    // a runaway job is stopped, its worker go on with other jobs
+    options.limits.cpu_time = std::chrono::seconds{5};
+    options.limits.memory_limit = 64 * 1024 * 1024;
+
+    ScriptExecutor executor{options};
+
+    const EmbeddedScript* script = FindEmbeddedScript("main.js");
+    if (!script) {
+        std::cerr << "embedded script main.js not found" << std::endl;
+        return 1;
+    }
+    // precompiled, workers only read the bytecode
+    std::vector<uint8_t> bytecode{script->data, script->data + script->size};
+
+    // long & short jobs are mixed, idle workers steal the short ones
+    std::vector<std::future<ScriptResult>> results;
+    for (int i = 0; i < 16; i++) {
+        ScriptJob job;
+        job.bytecode = bytecode;
+        job.input = std::to_string(i % 4 == 0 ? 30 : 10 + i);
+        results.push_back(executor.Submit(std::move(job)));
+    }
+
+    // exception is reported by result rather than printed by worker
+    ScriptJob bad_job;
+    bad_job.source = "throw new Error('bad script')";
+    results.push_back(executor.Submit(std::move(bad_job)));
+
+    ScriptJob endless_job;
+    endless_job.source = "for (;;) {}";
+    results.push_back(executor.Submit(std::move(endless_job)));
+
+    for (auto& future : results) {
+        ScriptResult result = future.get();
+        std::cout << (result.success ? "[ok] " : "[failed] ") << result.output
+                  << std::endl;
+    }
+    return 0;
+}
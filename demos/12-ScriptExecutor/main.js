@@ -0,0 +1,7 @@
+function fib(n) {
+    return n < 2 ? n : fib(n - 1) + fib(n - 2)
+}
+
+// `input` is given by ScriptJob::input, last expression is the result
+let n = parseInt(input);
+({ n: n, fib: fib(n) })
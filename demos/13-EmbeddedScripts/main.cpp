@@ -0,0 +1,39 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include "common.hpp"
+#include "embedded_scripts.hpp"
+
+int main() {
+    JSRuntime* runtime = JS_NewRuntime();
+    if (!runtime) {
+        std::cerr << "init runtime failed" << std::endl;
+        return 1;
+    }
+
+    JSContext* ctx = JS_NewContext(runtime);
+    if (!ctx) {
+        std::cerr << "create context failed" << std::endl;
+        JS_FreeRuntime(runtime);
+        return 2;
+    }
+
+    // must first add runtime handler
+    js_std_init_handlers(runtime);
+
+    js_std_add_helpers(ctx, 0, NULL);
+
+    // scripts are found by file name, independent of working directory
+    ExecuteEmbeddedScript(ctx, "prelude.js");
+    ExecuteEmbeddedScript(ctx, "main.js");
+
+    js_std_loop(ctx);
+
+    JS_FreeContext(ctx);
+
+    // don't forget free handlers
+    js_std_free_handlers(runtime);
+
+    JS_FreeRuntime(runtime);
+    return 0;
+}
@@ -0,0 +1,5 @@
+function main() {
+    console.log(greet("QJSKid"))
+}
+
+main()
@@ -0,0 +1,63 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include "binding.hpp"
+#include "common.hpp"
+#include "embedded_scripts.hpp"
+#include "module_loader.hpp"
+
+int Add(int a, int b) {
+    return a + b;
+}
+
+int ModuleInitFn(JSContext* ctx, JSModuleDef* m) {
+    std::cout << "MyModule is imported, create it now" << std::endl;
+    return JS_SetModuleExport(ctx, m, "Add", NewFunction<Add>(ctx, "Add"));
+}
+
+int main() {
+    // register all modules before runtime, nothing is created here
+    ModuleRegistry registry;
+    registry.AddNativeModule("std", js_init_module_std);
+    registry.AddNativeModule("os", js_init_module_os);
+    registry.AddNativeModule("bjson", js_init_module_bjson);
+    registry.AddNativeModule("MyModule", ModuleInitFn, {"Add"});
+
+    const EmbeddedScript* vec = FindEmbeddedScript("vec.js");
+    if (vec) {
+        registry.AddBytecodeModule("vec.js", vec->data, vec->size);
+    }
+
+    JSRuntime* runtime = JS_NewRuntime();
+    if (!runtime) {
+        std::cerr << "init runtime failed" << std::endl;
+        return 1;
+    }
+
+    registry.Install(runtime);
+
+    JSContext* ctx = JS_NewContext(runtime);
+    if (!ctx) {
+        std::cerr << "create context failed" << std::endl;
+        JS_FreeRuntime(runtime);
+        return 2;
+    }
+
+    // must first add runtime handler
+    js_std_init_handlers(runtime);
+
+    js_std_add_helpers(ctx, 0, NULL);
+
+    // imports host modules, which qjsc can't resolve at build time
+    ExecuteScript(ctx, "demos/14-LazyModule/main.js", JS_EVAL_TYPE_MODULE);
+
+    js_std_loop(ctx);
+
+    JS_FreeContext(ctx);
+
+    // don't forget free handlers
+    js_std_free_handlers(runtime);
+
+    JS_FreeRuntime(runtime);
+    return 0;
+}
@@ -0,0 +1,8 @@
+import * as std from 'std'
+import { Add } from 'MyModule'
+import { length } from 'vec.js'
+
+std.printf("Add(1, 2) = %d\n", Add(1, 2))
+std.printf("length(3, 4) = %d\n", length(3, 4))
+
+// 'os' and 'bjson' are registered but never imported, so never created
@@ -0,0 +1,3 @@
+export function length(x, y) {
+    return Math.sqrt(x * x + y * y)
+}
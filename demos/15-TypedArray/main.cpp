@@ -0,0 +1,100 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include "binding.hpp"
+#include "common.hpp"
+#include "embedded_scripts.hpp"
+#include "typed_array.hpp"
+#include <memory>
+#include <numeric>
+#include <vector>
+
+struct Mesh {
+    std::vector<float> vertices;
+
+    explicit Mesh(int vertex_count) : vertices(vertex_count * 3) {}
+
+    void Print() const {
+        for (float vertex : vertices) {
+            std::cout << vertex << " ";
+        }
+        std::cout << std::endl;
+    }
+};
+
+// script's Float32Array is passed as span, no copy
+float Sum(std::span<const float> values) {
+    return std::accumulate(values.begin(), values.end(), 0.0f);
+}
+
+using MeshBinder = ClassBinder<Mesh>;
+
+// This lifetime must longer than script JSValue
+const JSCFunctionListEntry entries[] = {
+    MeshBinder::Method<&Mesh::Print>("print"),
+    // Float32Array over Mesh::vertices
+    MeshBinder::Buffer<&Mesh::vertices>("vertices"),
+};
+
+void BindMesh(JSRuntime* runtime, JSContext* ctx) {
+    JSValue constructor = MeshBinder::Register<int>(
+        runtime, ctx, "Mesh", entries, std::size(entries));
+    if (JS_IsException(constructor)) {
+        js_std_dump_error(ctx);
+        return;
+    }
+
+    JSValue global_var = JS_GetGlobalObject(ctx);
+    QJS_CALL(JS_DefinePropertyValueStr(ctx, global_var, "Mesh", constructor,
+                                       JS_PROP_C_W_E));
+    JS_FreeValue(ctx, global_var);
+}
+
+int main() {
+    JSRuntime* runtime = JS_NewRuntime();
+    if (!runtime) {
+        std::cerr << "init runtime failed" << std::endl;
+        return 1;
+    }
+
+    JSContext* ctx = JS_NewContext(runtime);
+    if (!ctx) {
+        std::cerr << "create context failed" << std::endl;
+        JS_FreeRuntime(runtime);
+        return 2;
+    }
+
+    // must first add runtime handler
+    js_std_init_handlers(runtime);
+
+    js_std_add_helpers(ctx, 0, NULL);
+
+    BindMesh(runtime, ctx);
+    BindFunction<Sum>(ctx, "Sum");
+
+    auto samples = std::make_shared<std::vector<float>>(8, 1.0f);
+    JSValue global_var = JS_GetGlobalObject(ctx);
+    QJS_CALL(JS_DefinePropertyValueStr(ctx, global_var, "samples",
+                                       NewOwningTypedArray(ctx, samples),
+                                       JS_PROP_C_W_E));
+    JS_FreeValue(ctx, global_var);
+
+    ExecuteEmbeddedScript(ctx, "main.js");
+
+    js_std_loop(ctx);
+
+    // script wrote to the same memory
+    std::cout << "samples after script: ";
+    for (float sample : *samples) {
+        std::cout << sample << " ";
+    }
+    std::cout << std::endl;
+
+    JS_FreeContext(ctx);
+
+    // don't forget free handlers
+    js_std_free_handlers(runtime);
+
+    JS_FreeRuntime(runtime);
+    return 0;
+}
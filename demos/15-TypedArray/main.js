@@ -0,0 +1,13 @@
+// vertices is a Float32Array over Mesh's std::vector, no copy
+const mesh = new Mesh(4)
+const vertices = mesh.vertices
+for (let i = 0; i < vertices.length; i++) {
+    vertices[i] = i * 0.5
+}
+console.log("sum of vertices:", Sum(vertices))
+mesh.print()
+
+// samples is owned by both C++ and script, scale it in place
+for (let i = 0; i < samples.length; i++) {
+    samples[i] *= 2
+}
@@ -0,0 +1,72 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include "common.hpp"
+#include "embedded_scripts.hpp"
+#include "context_builder.hpp"
+#include <chrono>
+#include <functional>
+
+constexpr int ContextCount = 1000;
+
+// memory & time of creating (and freeing) ContextCount contexts
+void Measure(const char* title, JSRuntime* runtime,
+             const std::function<JSContext*(JSRuntime*)>& new_context) {
+    JSMemoryUsage before, after;
+    JS_ComputeMemoryUsage(runtime, &before);
+    JSContext* ctx = new_context(runtime);
+    JS_ComputeMemoryUsage(runtime, &after);
+    JS_FreeContext(ctx);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < ContextCount; i++) {
+        JS_FreeContext(new_context(runtime));
+    }
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - begin;
+
+    std::cout << title << ": "
+              << after.memory_used_size - before.memory_used_size
+              << " bytes, " << elapsed.count() / ContextCount << " us"
+              << std::endl;
+}
+
+int main() {
+    JSRuntime* runtime = JS_NewRuntime();
+    if (!runtime) {
+        std::cerr << "init runtime failed" << std::endl;
+        return 1;
+    }
+
+    ContextBuilder builder;
+    builder.Add(Intrinsic::JSON).Lazy(Intrinsic::Date | Intrinsic::MapSet);
+
+    Measure("JS_NewContext", runtime, JS_NewContext);
+    Measure("ContextBuilder", runtime, [&builder](JSRuntime* runtime) {
+        return builder.Build(runtime);
+    });
+
+    JSContext* ctx = builder.Build(runtime);
+    if (!ctx) {
+        std::cerr << "create context failed" << std::endl;
+        JS_FreeRuntime(runtime);
+        return 2;
+    }
+
+    // must first add runtime handler
+    js_std_init_handlers(runtime);
+
+    js_std_add_helpers(ctx, 0, NULL);
+
+    ExecuteEmbeddedScript(ctx, "main.js");
+
+    js_std_loop(ctx);
+
+    JS_FreeContext(ctx);
+
+    // don't forget free handlers
+    js_std_free_handlers(runtime);
+
+    JS_FreeRuntime(runtime);
+    return 0;
+}
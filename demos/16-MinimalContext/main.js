@@ -0,0 +1,13 @@
+function main() {
+    // arithmetic only need base objects
+    console.log("1 + 2 * 3 = ", 1 + 2 * 3)
+
+    // first access of Date install it
+    console.log("year: ", new Date(0).getUTCFullYear())
+
+    // Map is lazy too, JSON was added eagerly
+    const map = new Map([["a", 1]])
+    console.log(JSON.stringify([...map]))
+}
+
+main()
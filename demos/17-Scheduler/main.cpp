@@ -0,0 +1,139 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include "binding.hpp"
+#include "common.hpp"
+#include "embedded_scripts.hpp"
+#include "scheduler.hpp"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+constexpr int ContextCount = 100;
+
+int gFinished = 0;
+
+void Done(int id) {
+    gFinished++;
+    if (id == 0) {
+        std::cout << "context 0 finished" << std::endl;
+    }
+}
+
+#ifndef _WIN32
+// deliver lines written by another thread to context's onMessage
+std::thread WatchMessages(Scheduler& scheduler, JSContext* ctx) {
+    int fds[2];
+    if (pipe(fds) < 0) {
+        std::cerr << "create pipe failed" << std::endl;
+        return {};
+    }
+
+    int read_fd = fds[0];
+    scheduler.Watch(read_fd, Scheduler::Readable,
+                    [&scheduler, ctx, read_fd](uint32_t) {
+                        char buf[256];
+                        ssize_t len = read(read_fd, buf, sizeof(buf));
+                        if (len <= 0) {
+                            // writer closed
+                            scheduler.Unwatch(read_fd);
+                            close(read_fd);
+                            return;
+                        }
+
+                        JSValue global_this = JS_GetGlobalObject(ctx);
+                        JSValue fn =
+                            JS_GetPropertyStr(ctx, global_this, "onMessage");
+                        JSValue message = JS_NewStringLen(ctx, buf, len);
+                        JSValue result =
+                            JS_Call(ctx, fn, JS_UNDEFINED, 1, &message);
+                        CheckJSValue(ctx, result);
+                        JS_FreeValue(ctx, result);
+                        JS_FreeValue(ctx, message);
+                        JS_FreeValue(ctx, fn);
+                        JS_FreeValue(ctx, global_this);
+                    });
+
+    int write_fd = fds[1];
+    return std::thread{[write_fd] {
+        for (int i = 0; i < 3; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{15});
+            std::string message = "hello " + std::to_string(i);
+            if (write(write_fd, message.data(), message.size()) < 0) {
+                break;
+            }
+        }
+        close(write_fd);
+    }};
+}
+#endif
+
+int main() {
+    JSRuntime* runtime = JS_NewRuntime();
+    if (!runtime) {
+        std::cerr << "init runtime failed" << std::endl;
+        return 1;
+    }
+
+    // must first add runtime handler
+    js_std_init_handlers(runtime);
+
+    std::vector<JSContext*> contexts;
+    {
+        Scheduler scheduler{runtime};
+
+        // all contexts share one runtime & one thread
+        for (int i = 0; i < ContextCount; i++) {
+            JSContext* ctx = JS_NewContext(runtime);
+            if (!ctx) {
+                std::cerr << "create context failed" << std::endl;
+                break;
+            }
+            contexts.push_back(ctx);
+
+            js_std_add_helpers(ctx, 0, NULL);
+            scheduler.AddContext(ctx);
+            BindFunction<Done>(ctx, "Done");
+
+            JSValue global_this = JS_GetGlobalObject(ctx);
+            JS_SetPropertyStr(ctx, global_this, "id", JS_NewInt32(ctx, i));
+            JS_FreeValue(ctx, global_this);
+
+            ExecuteEmbeddedScript(ctx, "main.js");
+        }
+
+#ifndef _WIN32
+        std::thread writer = WatchMessages(scheduler, contexts.front());
+#endif
+
+        // replace js_std_loop of every context
+        auto begin = std::chrono::steady_clock::now();
+        scheduler.Run();
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - begin;
+        std::cout << gFinished << "/" << contexts.size()
+                  << " contexts finished in " << elapsed.count()
+                  << " ms on one thread" << std::endl;
+
+#ifndef _WIN32
+        if (writer.joinable()) {
+            writer.join();
+        }
+#endif
+
+        for (JSContext* ctx : contexts) {
+            scheduler.RemoveContext(ctx);
+            JS_FreeContext(ctx);
+        }
+    }
+
+    // don't forget free handlers
+    js_std_free_handlers(runtime);
+
+    JS_FreeRuntime(runtime);
+    return 0;
+}
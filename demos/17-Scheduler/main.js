@@ -0,0 +1,17 @@
+function sleep(ms) {
+    return new Promise(resolve => setTimeout(resolve, ms))
+}
+
+async function main() {
+    // mostly idle: wait on timers, no thread is blocked meanwhile
+    for (let i = 0; i < 3; i++) {
+        await sleep(10 * (id % 5))
+    }
+    Done(id)
+}
+
+globalThis.onMessage = function (message) {
+    console.log("context", id, "got message:", message)
+}
+
+main()
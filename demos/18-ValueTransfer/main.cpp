@@ -0,0 +1,108 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include "common.hpp"
+#include "embedded_scripts.hpp"
+#include "shared_memory.hpp"
+#include "value_transfer.hpp"
+#include <thread>
+
+struct Engine {
+    JSRuntime* runtime = nullptr;
+    JSContext* ctx = nullptr;
+
+    bool Init() {
+        runtime = JS_NewRuntime();
+        if (!runtime) {
+            std::cerr << "init runtime failed" << std::endl;
+            return false;
+        }
+        // must first add runtime handler
+        js_std_init_handlers(runtime);
+        // both sides must use the same memory for SharedArrayBuffer
+        EnableSharedArrayBuffers(runtime);
+
+        ctx = JS_NewContext(runtime);
+        if (!ctx) {
+            std::cerr << "create context failed" << std::endl;
+            return false;
+        }
+
+        js_std_add_helpers(ctx, 0, NULL);
+        return true;
+    }
+
+    ~Engine() {
+        if (ctx) {
+            JS_FreeContext(ctx);
+        }
+        if (runtime) {
+            // don't forget free handlers
+            js_std_free_handlers(runtime);
+            JS_FreeRuntime(runtime);
+        }
+    }
+};
+
+// runtime B on its own thread, like a worker
+void Receive(ValueMessage message) {
+    Engine engine;
+    if (!engine.Init()) {
+        return;
+    }
+    JSContext* ctx = engine.ctx;
+    ExecuteEmbeddedScript(ctx, "worker.js");
+
+    JSValue value = DeserializeValue(ctx, message);
+    if (JS_IsException(value)) {
+        js_std_dump_error(ctx);
+        return;
+    }
+
+    JSValue global_var = JS_GetGlobalObject(ctx);
+    JSValue on_message = JS_GetPropertyStr(ctx, global_var, "onMessage");
+    JSValue result = JS_Call(ctx, on_message, JS_UNDEFINED, 1, &value);
+    CheckJSValue(ctx, result);
+    JS_FreeValue(ctx, result);
+    JS_FreeValue(ctx, on_message);
+    JS_FreeValue(ctx, global_var);
+    JS_FreeValue(ctx, value);
+}
+
+int main() {
+    Engine engine;
+    if (!engine.Init()) {
+        return 1;
+    }
+    JSContext* ctx = engine.ctx;
+    ExecuteEmbeddedScript(ctx, "main.js");
+
+    JSValue global_var = JS_GetGlobalObject(ctx);
+    JSValue value = JS_GetPropertyStr(ctx, global_var, "message");
+    JSValue pixels = JS_GetPropertyStr(ctx, global_var, "pixels");
+
+    // pixels is moved into message, detached here
+    ValueMessage message;
+    if (!SerializeValue(ctx, value, message, &pixels, 1)) {
+        js_std_dump_error(ctx);
+    }
+    std::cout << "message size: " << message.Size() << " bytes" << std::endl;
+    JS_FreeValue(ctx, pixels);
+    JS_FreeValue(ctx, value);
+    JS_FreeValue(ctx, global_var);
+
+    std::thread worker{Receive, std::move(message)};
+    worker.join();
+
+    // the write of runtime B is visible without copying back
+    global_var = JS_GetGlobalObject(ctx);
+    JSValue report = JS_GetPropertyStr(ctx, global_var, "report");
+    JSValue result = JS_Call(ctx, report, JS_UNDEFINED, 0, nullptr);
+    CheckJSValue(ctx, result);
+    JS_FreeValue(ctx, result);
+    JS_FreeValue(ctx, report);
+    JS_FreeValue(ctx, global_var);
+
+    js_std_loop(ctx);
+    return 0;
+}
@@ -0,0 +1,19 @@
+// runtime A: build message, memory of `shared` is seen by both runtimes
+globalThis.shared = new SharedArrayBuffer(4 * 4);
+globalThis.pixels = new Uint8Array([1, 2, 3, 4]).buffer;
+
+const node = { name: "root", tags: new Map([["kind", "tree"]]) };
+node.self = node;
+
+globalThis.message = {
+    node,
+    created: new Date(0),
+    counters: new Int32Array(shared),
+    pixels,
+};
+
+// called after runtime B is done
+globalThis.report = function () {
+    console.log("counter:", new Int32Array(shared)[0]);
+    console.log("pixels moved:", pixels.byteLength === 0);
+};
@@ -0,0 +1,9 @@
+// runtime B: receive message from runtime A
+globalThis.onMessage = function (message) {
+    console.log("cycle kept:", message.node.self === message.node);
+    console.log("map:", message.node.tags.get("kind"));
+    console.log("pixels:", new Uint8Array(message.pixels).join(","));
+
+    // write through the same memory as runtime A
+    Atomics.add(message.counters, 0, 42);
+};
@@ -0,0 +1,88 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include <atomic>
+
+#include "common.hpp"
+#include "embedded_scripts.hpp"
+#include "script_executor.hpp"
+#include "shared_memory.hpp"
+
+// must match main.js
+constexpr int LetterCount = 26;
+constexpr int RingSize = 8;
+
+const char* gSentences[] = {
+    "the quick brown fox jumps over the lazy dog",
+    "pack my box with five dozen liquor jugs",
+    "how vexingly quick daft zebras jump",
+    "sphinx of black quartz judge my vow",
+};
+
+int main() {
+    // allocated once, every worker runtime map the same memory
+    SharedRegion region{(LetterCount + 1 + RingSize) * sizeof(int32_t)};
+    if (!region) {
+        std::cerr << "allocate shared region failed" << std::endl;
+        return 1;
+    }
+
+    ExecutorOptions options;
+    options.worker_count = 4;
+    options.init_context = [region](JSRuntime*, JSContext* ctx) {
+        js_std_add_helpers(ctx, 0, NULL);
+
+        JSValue buffer = region.NewArrayBuffer(ctx);
+        if (JS_IsException(buffer)) {
+            return false;
+        }
+        JSValue global_var = JS_GetGlobalObject(ctx);
+        int ret = JS_DefinePropertyValueStr(ctx, global_var, "shared", buffer,
+                                            JS_PROP_C_W_E);
+        JS_FreeValue(ctx, global_var);
+        return ret >= 0;
+    };
+
+    const EmbeddedScript* script = FindEmbeddedScript("main.js");
+    if (!script) {
+        std::cerr << "embedded script main.js not found" << std::endl;
+        return 1;
+    }
+    std::vector<uint8_t> bytecode{script->data, script->data + script->size};
+
+    {
+        ScriptExecutor executor{options};
+
+        std::vector<std::future<ScriptResult>> results;
+        for (int i = 0; i < 64; i++) {
+            ScriptJob job;
+            job.bytecode = bytecode;
+            job.input = gSentences[i % std::size(gSentences)];
+            results.push_back(executor.Submit(std::move(job)));
+        }
+        for (auto& future : results) {
+            ScriptResult result = future.get();
+            if (!result.success) {
+                std::cerr << result.output << std::endl;
+            }
+        }
+    }
+
+    // scripts wrote with Atomics, read the same way
+    auto values = region.As<int32_t>();
+    std::cout << "letters:";
+    for (int i = 0; i < LetterCount; i++) {
+        int32_t count = std::atomic_ref{values[i]}.load();
+        std::cout << " " << static_cast<char>('a' + i) << "=" << count;
+    }
+    std::cout << std::endl;
+
+    int32_t* ring = values + LetterCount;
+    std::cout << "jobs: " << std::atomic_ref{ring[0]}.load()
+              << ", latest totals:";
+    for (int i = 0; i < RingSize; i++) {
+        std::cout << " " << std::atomic_ref{ring[1 + i]}.load();
+    }
+    std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,22 @@
+// every worker see the same `shared`, no lock & no C++ callback
+const LetterCount = 26;
+const RingSize = 8;
+
+const letters = new Int32Array(shared, 0, LetterCount);
+// [0]: write position, then RingSize slots
+const ring = new Int32Array(shared, LetterCount * 4, 1 + RingSize);
+
+let total = 0;
+for (const ch of input.toLowerCase()) {
+    const index = ch.charCodeAt(0) - 97;
+    if (index >= 0 && index < LetterCount) {
+        Atomics.add(letters, index, 1);
+        total++;
+    }
+}
+
+// keep latest totals
+const slot = Atomics.add(ring, 0, 1) % RingSize;
+Atomics.store(ring, 1 + slot, total);
+
+total;
@@ -0,0 +1,121 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include <cmath>
+#include <fstream>
+
+#include "binding.hpp"
+#include "common.hpp"
+#include "embedded_scripts.hpp"
+#include "native_profiler.hpp"
+
+struct Vec2 {
+    double x;
+    double y;
+
+    Vec2(double x, double y) : x{x}, y{y} {}
+};
+
+double Distance(double x1, double y1, double x2, double y2) {
+    return std::hypot(x2 - x1, y2 - y1);
+}
+
+int Wrap(int value, int limit) {
+    return value % limit;
+}
+
+void Label(const std::string& text) {
+    std::cout << text << std::endl;
+}
+
+// hand-written thunk, profiled by ProfileScope like the generated ones
+JSValue Repeat(JSContext* ctx, JSValueConst, int argc, JSValueConst* argv) {
+    ProfileScope<&Repeat> scope{ctx};
+
+    int count;
+    if (argc < 2 || JS_ToInt32(ctx, &count, argv[1]) < 0) {
+        return JS_ThrowTypeError(ctx, "expect callback & count");
+    }
+    ProfileArgumentsLoaded();
+
+    for (int i = 0; i < count; i++) {
+        JSValue result = JS_Call(ctx, argv[0], JS_UNDEFINED, 0, nullptr);
+        if (JS_IsException(result)) {
+            return result;
+        }
+        JS_FreeValue(ctx, result);
+    }
+    return JS_UNDEFINED;
+}
+
+using Vec2Binder = ClassBinder<Vec2>;
+
+// This lifetime must longer than script JSValue
+const JSCFunctionListEntry entries[] = {
+    Vec2Binder::Field<&Vec2::x>("x"),
+    Vec2Binder::Field<&Vec2::y>("y"),
+};
+
+void BindAll(JSRuntime* runtime, JSContext* ctx) {
+    JSValue constructor = Vec2Binder::Register<double, double>(
+        runtime, ctx, "Vec2", entries, std::size(entries));
+    if (JS_IsException(constructor)) {
+        js_std_dump_error(ctx);
+        return;
+    }
+
+    JSValue global_var = JS_GetGlobalObject(ctx);
+    QJS_CALL(JS_DefinePropertyValueStr(ctx, global_var, "Vec2", constructor,
+                                       JS_PROP_C_W_E));
+
+    NameProfileSite(detail::ProfileKey(Repeat), "Repeat");
+    QJS_CALL(JS_SetPropertyStr(ctx, global_var, "Repeat",
+                               JS_NewCFunction(ctx, Repeat, "Repeat", 2)));
+    JS_FreeValue(ctx, global_var);
+
+    BindFunction<Distance>(ctx, "Distance");
+    BindFunction<Wrap>(ctx, "Wrap");
+    BindFunction<Label>(ctx, "Label");
+}
+
+int main() {
+    JSRuntime* runtime = JS_NewRuntime();
+    if (!runtime) {
+        std::cerr << "init runtime failed" << std::endl;
+        return 1;
+    }
+
+    JSContext* ctx = JS_NewContext(runtime);
+    if (!ctx) {
+        std::cerr << "create context failed" << std::endl;
+        JS_FreeRuntime(runtime);
+        return 2;
+    }
+
+    // must first add runtime handler
+    js_std_init_handlers(runtime);
+
+    js_std_add_helpers(ctx, 0, NULL);
+
+    // before binding, so functions are registered with names & thunks
+    EnableProfiling(runtime);
+    BindAll(runtime, ctx);
+
+    ExecuteEmbeddedScript(ctx, "main.js");
+
+    js_std_loop(ctx);
+
+    WriteProfileReport(std::cout);
+    // render by `flamegraph.pl native.folded > native.svg` or speedscope
+    std::ofstream folded{"native.folded"};
+    WriteCollapsedStacks(folded);
+
+    DisableProfiling(runtime);
+    JS_FreeContext(ctx);
+
+    // don't forget free handlers
+    js_std_free_handlers(runtime);
+
+    JS_FreeRuntime(runtime);
+    return 0;
+}
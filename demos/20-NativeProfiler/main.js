@@ -0,0 +1,20 @@
+function main() {
+    const points = []
+    for (let i = 0; i < 1000; i++) {
+        points.push(new Vec2(i, i * 0.5))
+    }
+
+    let total = 0
+    for (let round = 0; round < 100; round++) {
+        for (const point of points) {
+            total += Distance(point.x, point.y, 0, 0)
+            point.x = Wrap(point.x + 1, 1000)
+        }
+    }
+
+    // natives called inside another native show up as nested stacks
+    Repeat(() => Distance(1, 2, 3, 4), 10000)
+    Label("total: " + total)
+}
+
+main()
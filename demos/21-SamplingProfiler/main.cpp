@@ -0,0 +1,68 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include <fstream>
+
+#include "common.hpp"
+#include "embedded_scripts.hpp"
+#include "execution_budget.hpp"
+#include "sampling_profiler.hpp"
+
+int main() {
+    JSRuntime* runtime = JS_NewRuntime();
+    if (!runtime) {
+        std::cerr << "init runtime failed" << std::endl;
+        return 1;
+    }
+
+    JSContext* ctx = JS_NewContext(runtime);
+    if (!ctx) {
+        std::cerr << "create context failed" << std::endl;
+        JS_FreeRuntime(runtime);
+        return 2;
+    }
+
+    // must first add runtime handler
+    js_std_init_handlers(runtime);
+
+    js_std_add_helpers(ctx, 0, NULL);
+
+    {
+        ExecutionBudget budget{runtime};
+        ExecutionLimits limits;
+        limits.cpu_time = std::chrono::seconds{10};
+
+        // budget's limits still work while sampling
+        SamplerOptions options;
+        options.interval = std::chrono::microseconds{500};
+        SamplingProfiler profiler{runtime, options, &budget};
+
+        if (!profiler.Start(ctx)) {
+            js_std_dump_error(ctx);
+        }
+        {
+            ScopedBudget scoped{budget, limits};
+            ExecuteEmbeddedScript(ctx, "main.js");
+            js_std_loop(ctx);
+        }
+        profiler.Stop();
+
+        std::cout << "samples: " << profiler.SampleCount() << ", budget: "
+                  << ToString(budget.Status()) << std::endl;
+
+        // `go tool pprof -top profile.pb`
+        std::ofstream pprof{"profile.pb", std::ios::binary};
+        profiler.WritePprof(pprof);
+        // open in chrome://tracing or ui.perfetto.dev
+        std::ofstream trace{"trace.json"};
+        profiler.WriteChromeTrace(trace);
+    }
+
+    JS_FreeContext(ctx);
+
+    // don't forget free handlers
+    js_std_free_handlers(runtime);
+
+    JS_FreeRuntime(runtime);
+    return 0;
+}
@@ -0,0 +1,27 @@
+function fib(n) {
+    return n < 2 ? n : fib(n - 1) + fib(n - 2)
+}
+
+function buildReport(count) {
+    let text = ""
+    for (let i = 0; i < count; i++) {
+        text += `line ${i}: ${Math.sqrt(i).toFixed(3)}\n`
+    }
+    return text.length
+}
+
+function sortNumbers(count) {
+    const values = []
+    for (let i = 0; i < count; i++) {
+        values.push((i * 7919) % 10007)
+    }
+    return values.sort((a, b) => a - b)[0]
+}
+
+function main() {
+    console.log("fib:", fib(27))
+    console.log("report:", buildReport(200000))
+    console.log("sorted:", sortNumbers(300000))
+}
+
+main()
@@ -0,0 +1,113 @@
+#include "quickjs-libc.h"
+#include "quickjs.h"
+
+#include <cstring>
+
+#include "arena_allocator.hpp"
+#include "binding.hpp"
+#include "common.hpp"
+#include "memory_telemetry.hpp"
+#include "module_loader.hpp"
+
+struct Particle {
+    double x;
+    double y;
+
+    Particle(double x, double y) : x{x}, y{y} {}
+};
+
+using ParticleBinder = ClassBinder<Particle>;
+
+// This lifetime must longer than script JSValue
+const JSCFunctionListEntry entries[] = {
+    ParticleBinder::Field<&Particle::x>("x"),
+    ParticleBinder::Field<&Particle::y>("y"),
+};
+
+int ParticleModuleInit(JSContext* ctx, JSModuleDef* m) {
+    JSValue constructor = ParticleBinder::Register<double, double>(
+        JS_GetRuntime(ctx), ctx, "Particle", entries, std::size(entries));
+    if (JS_IsException(constructor)) {
+        return -1;
+    }
+    return JS_SetModuleExport(ctx, m, "Particle", constructor);
+}
+
+const char* gTableSource = R"(
+export function makeTable(count) {
+    const rows = []
+    for (let i = 0; i < count; i++) {
+        rows.push({ id: i, name: "row" + i })
+    }
+    return rows
+}
+)";
+
+// module from source, compiled when first imported
+JSModuleDef* LoadTableModule(JSContext* ctx, const char* name) {
+    JSValue obj = JS_Eval(ctx, gTableSource, strlen(gTableSource), name,
+                          JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    if (JS_IsException(obj)) {
+        return nullptr;
+    }
+    auto module_def = static_cast<JSModuleDef*>(JS_VALUE_GET_PTR(obj));
+    JS_FreeValue(ctx, obj);
+    return module_def;
+}
+
+int main() {
+    MemoryTelemetry telemetry;
+
+    ModuleRegistry registry;
+    registry.AddNativeModule("particles", ParticleModuleInit, {"Particle"});
+    registry.AddNativeModule("table", LoadTableModule);
+    registry.TrackMemory(&telemetry);
+
+    // the arena counts allocated bytes, so sampling doesn't walk the heap
+    RuntimeArena arena;
+    JSRuntime* runtime = NewRuntimeWithAllocator(arena);
+    if (!runtime) {
+        std::cerr << "init runtime failed" << std::endl;
+        return 1;
+    }
+    telemetry.AddRuntime(runtime, "main", &arena);
+    registry.Install(runtime);
+
+    JSContext* ctx = JS_NewContext(runtime);
+    if (!ctx) {
+        std::cerr << "create context failed" << std::endl;
+        telemetry.RemoveRuntime(runtime);
+        arena.ReleaseRuntime(runtime);
+        return 2;
+    }
+
+    // must first add runtime handler
+    js_std_init_handlers(runtime);
+
+    js_std_add_helpers(ctx, 0, NULL);
+
+    // imports host modules, which qjsc can't resolve at build time
+    ExecuteScript(ctx, "demos/22-MemoryTelemetry/main.js",
+                  JS_EVAL_TYPE_MODULE);
+
+    js_std_loop(ctx);
+
+    // particles not kept by script are collected
+    JS_RunGC(runtime);
+
+    /* a server would Sample every second, SampleHeap every minute or so &
+     * serve the text on /metrics
+     */
+    telemetry.Sample(runtime);
+    telemetry.SampleHeap(runtime);
+    telemetry.WritePrometheus(std::cout);
+
+    telemetry.RemoveRuntime(runtime);
+    JS_FreeContext(ctx);
+
+    // don't forget free handlers
+    js_std_free_handlers(runtime);
+
+    arena.ReleaseRuntime(runtime);
+    return 0;
+}
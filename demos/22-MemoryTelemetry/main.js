@@ -0,0 +1,10 @@
+import { Particle } from "particles"
+import { makeTable } from "table"
+
+const particles = []
+for (let i = 0; i < 1000; i++) {
+    particles.push(new Particle(i, i * 2))
+}
+globalThis.keep = particles.slice(0, 100)
+
+console.log("table rows:", makeTable(5000).length)
@@ -0,0 +1,52 @@
+# generate C++ source which embeds bytecode files as constexpr arrays, plus
+# FindEmbeddedScript() declared in embedded_scripts.hpp
+#
+# usage: cmake -DOUTPUT=<file.cpp> -DINPUTS=<a.js.qjs|b.js.qjs> -P EmbedScripts.cmake
+# script name is the bytecode file name without `.qjs`
+
+string(REPLACE "|" ";" INPUTS "${INPUTS}")
+
+set(content "// generated by EmbedScripts.cmake, don't edit\n\n")
+string(APPEND content "#include \"embedded_scripts.hpp\"\n")
+string(APPEND content "#include <algorithm>\n#include <iterator>\n\n")
+string(APPEND content "namespace {\n\n")
+
+set(table "")
+set(index 0)
+foreach(input ${INPUTS})
+    get_filename_component(name ${input} NAME_WLE)
+    file(READ ${input} hex HEX)
+    string(LENGTH "${hex}" hex_len)
+    math(EXPR size "${hex_len} / 2")
+
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1, " bytes "${hex}")
+    # 12 bytes per line (cmake regex has no {n} quantifier)
+    string(REPEAT "0x.., " 12 line_pattern)
+    string(REGEX REPLACE "(${line_pattern})" "\\1\n    " bytes "${bytes}")
+    string(REGEX REPLACE " +\n" "\n" bytes "${bytes}")
+    string(STRIP "${bytes}" bytes)
+
+    string(APPEND content "// ${name}\n")
+    string(APPEND content "constexpr uint8_t Script${index}[] = {\n    ${bytes}\n};\n\n")
+    string(APPEND table "    {\"${name}\", Script${index}, ${size}},\n")
+    math(EXPR index "${index} + 1")
+endforeach()
+
+string(APPEND content "constexpr EmbeddedScript Scripts[] = {\n${table}};\n\n")
+string(APPEND content "}  // namespace\n\n")
+string(APPEND content "const EmbeddedScript* FindEmbeddedScript(std::string_view name) {\n")
+string(APPEND content "    auto it = std::find_if(std::begin(Scripts), std::end(Scripts),\n")
+string(APPEND content "                           [name](const EmbeddedScript& script) {\n")
+string(APPEND content "                               return script.name == name;\n")
+string(APPEND content "                           });\n")
+string(APPEND content "    return it == std::end(Scripts) ? nullptr : &*it;\n")
+string(APPEND content "}\n")
+
+# don't touch output when nothing changed, avoid needless recompile
+set(old_content "")
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} old_content)
+endif()
+if(NOT old_content STREQUAL content)
+    file(WRITE ${OUTPUT} "${content}")
+endif()
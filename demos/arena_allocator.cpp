@@ -0,0 +1,248 @@
+#include "arena_allocator.hpp"
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// placed right before every pointer given to quickjs, keep 16 bytes alignment
+struct alignas(16) ChunkHeader {
+    size_t usable_size;
+    uint32_t size_class;
+};
+
+static_assert(sizeof(ChunkHeader) == 16);
+
+constexpr uint32_t LargeSizeClass = UINT32_MAX;
+
+/* 16 ~ 128 by step 16, then 4 classes per power of two up to 4096:
+ * 160 192 224 256 | 320 384 448 512 | ... | 2560 3072 3584 4096
+ */
+constexpr std::array<uint32_t, RuntimeArena::SizeClassCount> SizeClasses =
+    [] {
+        std::array<uint32_t, RuntimeArena::SizeClassCount> sizes{};
+        size_t i = 0;
+        for (uint32_t size = 16; size <= 128; size += 16) {
+            sizes[i++] = size;
+        }
+        for (uint32_t base = 128; base < RuntimeArena::MaxSmallSize;
+             base *= 2) {
+            for (uint32_t step = 1; step <= 4; step++) {
+                sizes[i++] = base + base / 4 * step;
+            }
+        }
+        return sizes;
+    }();
+
+static_assert(SizeClasses.back() == RuntimeArena::MaxSmallSize);
+
+// size (in 16 bytes granularity) -> size class index, O(1) lookup
+constexpr std::array<uint8_t, RuntimeArena::MaxSmallSize / 16 + 1>
+    SizeClassTable = [] {
+        std::array<uint8_t, RuntimeArena::MaxSmallSize / 16 + 1> table{};
+        uint8_t size_class = 0;
+        for (size_t i = 0; i < table.size(); i++) {
+            while (SizeClasses[size_class] < i * 16) {
+                size_class++;
+            }
+            table[i] = size_class;
+        }
+        return table;
+    }();
+
+ChunkHeader* GetHeader(const void* ptr) {
+    return reinterpret_cast<ChunkHeader*>(
+               const_cast<uint8_t*>(static_cast<const uint8_t*>(ptr))) -
+           1;
+}
+
+}  // namespace
+
+struct alignas(16) RuntimeArena::Block {
+    Block* next;
+};
+
+struct alignas(16) RuntimeArena::LargeHeader {
+    LargeHeader* prev;
+    LargeHeader* next;
+    ChunkHeader header;
+};
+
+RuntimeArena::RuntimeArena(size_t memory_limit)
+    : m_memory_limit{memory_limit} {}
+
+RuntimeArena::~RuntimeArena() {
+    ReleaseAll();
+}
+
+void* RuntimeArena::Malloc(size_t size) {
+    void* ptr = size <= MaxSmallSize
+                    ? MallocSmall(SizeClassTable[(size + 15) / 16])
+                    : MallocLarge(size);
+    if (!ptr) {
+        m_stats.failed_count++;
+        return nullptr;
+    }
+
+    m_stats.alloc_count++;
+    m_stats.used_bytes += UsableSize(ptr);
+    if (m_stats.used_bytes > m_stats.peak_used_bytes) {
+        m_stats.peak_used_bytes = m_stats.used_bytes;
+    }
+    return ptr;
+}
+
+void* RuntimeArena::Calloc(size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return nullptr;
+    }
+    void* ptr = Malloc(count * size);
+    if (ptr) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+void RuntimeArena::Free(void* ptr) {
+    // all memory will be dropped by ReleaseRuntime, don't bother
+    if (!ptr || m_tearing_down) {
+        return;
+    }
+
+    ChunkHeader* header = GetHeader(ptr);
+    m_stats.used_bytes -= header->usable_size;
+
+    if (header->size_class != LargeSizeClass) {
+        FreeNode* node = static_cast<FreeNode*>(ptr);
+        node->next = m_free_lists[header->size_class];
+        m_free_lists[header->size_class] = node;
+        return;
+    }
+
+    LargeHeader* large = reinterpret_cast<LargeHeader*>(
+        reinterpret_cast<uint8_t*>(header) - offsetof(LargeHeader, header));
+    if (large->prev) {
+        large->prev->next = large->next;
+    } else {
+        m_large_list = large->next;
+    }
+    if (large->next) {
+        large->next->prev = large->prev;
+    }
+    m_stats.reserved_bytes -= sizeof(LargeHeader) + header->usable_size;
+    std::free(large);
+}
+
+void* RuntimeArena::Realloc(void* ptr, size_t size) {
+    if (!ptr) {
+        return Malloc(size);
+    }
+    if (size == 0) {
+        Free(ptr);
+        return nullptr;
+    }
+
+    size_t old_size = UsableSize(ptr);
+    if (size <= old_size) {
+        return ptr;
+    }
+
+    void* new_ptr = Malloc(size);
+    if (!new_ptr) {
+        return nullptr;
+    }
+    memcpy(new_ptr, ptr, old_size);
+    Free(ptr);
+    return new_ptr;
+}
+
+size_t RuntimeArena::UsableSize(const void* ptr) {
+    return ptr ? GetHeader(ptr)->usable_size : 0;
+}
+
+void RuntimeArena::ReleaseRuntime(JSRuntime* runtime) {
+    m_tearing_down = true;
+    JS_FreeRuntime(runtime);
+    m_tearing_down = false;
+    ReleaseAll();
+}
+
+void* RuntimeArena::MallocSmall(size_t size_class) {
+    if (FreeNode* node = m_free_lists[size_class]) {
+        m_free_lists[size_class] = node->next;
+        return node;
+    }
+
+    size_t size = SizeClasses[size_class];
+    size_t chunk_size = sizeof(ChunkHeader) + size;
+    if (static_cast<size_t>(m_bump_end - m_bump) < chunk_size) {
+        // remain of current block is dropped, it is small compared with block
+        if (!Reserve(BlockSize)) {
+            return nullptr;
+        }
+        Block* block = static_cast<Block*>(std::malloc(BlockSize));
+        if (!block) {
+            m_stats.reserved_bytes -= BlockSize;
+            return nullptr;
+        }
+        block->next = m_blocks;
+        m_blocks = block;
+        m_bump = reinterpret_cast<uint8_t*>(block) + sizeof(Block);
+        m_bump_end = reinterpret_cast<uint8_t*>(block) + BlockSize;
+    }
+
+    ChunkHeader* header = reinterpret_cast<ChunkHeader*>(m_bump);
+    header->usable_size = size;
+    header->size_class = static_cast<uint32_t>(size_class);
+    m_bump += chunk_size;
+    return header + 1;
+}
+
+void* RuntimeArena::MallocLarge(size_t size) {
+    // keep 16 bytes alignment for the next allocation's header
+    size = (size + 15) & ~size_t(15);
+    size_t total_size = sizeof(LargeHeader) + size;
+    if (!Reserve(total_size)) {
+        return nullptr;
+    }
+
+    LargeHeader* large = static_cast<LargeHeader*>(std::malloc(total_size));
+    if (!large) {
+        m_stats.reserved_bytes -= total_size;
+        return nullptr;
+    }
+    large->prev = nullptr;
+    large->next = m_large_list;
+    if (m_large_list) {
+        m_large_list->prev = large;
+    }
+    m_large_list = large;
+    large->header.usable_size = size;
+    large->header.size_class = LargeSizeClass;
+    return &large->header + 1;
+}
+
+bool RuntimeArena::Reserve(size_t size) {
+    if (m_memory_limit != 0 &&
+        m_stats.reserved_bytes + size > m_memory_limit) {
+        return false;
+    }
+    m_stats.reserved_bytes += size;
+    return true;
+}
+
+void RuntimeArena::ReleaseAll() {
+    while (m_blocks) {
+        Block* next = m_blocks->next;
+        std::free(m_blocks);
+        m_blocks = next;
+    }
+    while (m_large_list) {
+        LargeHeader* next = m_large_list->next;
+        std::free(m_large_list);
+        m_large_list = next;
+    }
+    m_free_lists.fill(nullptr);
+    m_bump = m_bump_end = nullptr;
+    m_stats.reserved_bytes = 0;
+    m_stats.used_bytes = 0;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "quickjs.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/* per-runtime memory arena for quickjs (set by JS_NewRuntime2)
+ *
+ * small allocations are served by size-class free lists carved from big
+ * blocks, large ones go to malloc but are still tracked by the arena. All
+ * memory is released at once in ReleaseRuntime(), so tearing down a runtime
+ * doesn't give every object back to libc one by one.
+ *
+ * one arena serve one runtime, it is not thread-safe (neither is runtime)
+ */
+
+struct ArenaStats {
+    size_t reserved_bytes = 0;  // blocks + large allocations from system
+    size_t used_bytes = 0;      // bytes handed out to quickjs
+    size_t peak_used_bytes = 0;
+    size_t alloc_count = 0;
+    size_t failed_count = 0;    // rejected by memory limit or system
+};
+
+class RuntimeArena {
+public:
+    static constexpr size_t BlockSize = 64 * 1024;
+    static constexpr size_t MaxSmallSize = 4096;
+    static constexpr size_t SizeClassCount = 28;
+
+    // memory_limit: hard cap of reserved bytes, 0 means no limit
+    explicit RuntimeArena(size_t memory_limit = 0);
+    RuntimeArena(const RuntimeArena&) = delete;
+    RuntimeArena& operator=(const RuntimeArena&) = delete;
+    ~RuntimeArena();
+
+    void* Malloc(size_t size);
+    void* Calloc(size_t count, size_t size);
+    void Free(void* ptr);
+    void* Realloc(void* ptr, size_t size);
+    static size_t UsableSize(const void* ptr);
+
+    /* JS_FreeRuntime with per-object free skipped (finalizers still run),
+     * then release all memory of the arena. The arena can be reused by a new
+     * runtime after that
+     */
+    void ReleaseRuntime(JSRuntime* runtime);
+
+    const ArenaStats& Stats() const { return m_stats; }
+
+private:
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    struct Block;
+    struct LargeHeader;
+
+    std::array<FreeNode*, SizeClassCount> m_free_lists{};
+    Block* m_blocks = nullptr;
+    uint8_t* m_bump = nullptr;
+    uint8_t* m_bump_end = nullptr;
+    LargeHeader* m_large_list = nullptr;
+    size_t m_memory_limit;
+    bool m_tearing_down = false;
+    ArenaStats m_stats;
+
+    void* MallocSmall(size_t size_class);
+    void* MallocLarge(size_t size);
+    bool Reserve(size_t size);
+    void ReleaseAll();
+};
+
+// create runtime whose memory come from allocator, Allocator need
+// Malloc/Calloc/Free/Realloc and static UsableSize (like RuntimeArena)
+template <typename Allocator>
+JSRuntime* NewRuntimeWithAllocator(Allocator& allocator) {
+    static const JSMallocFunctions functions = [] {
+        JSMallocFunctions mf{};
+        mf.js_calloc = +[](void* opaque, size_t count, size_t size) {
+            return static_cast<Allocator*>(opaque)->Calloc(count, size);
+        };
+        mf.js_malloc = +[](void* opaque, size_t size) {
+            return static_cast<Allocator*>(opaque)->Malloc(size);
+        };
+        mf.js_free = +[](void* opaque, void* ptr) {
+            static_cast<Allocator*>(opaque)->Free(ptr);
+        };
+        mf.js_realloc = +[](void* opaque, void* ptr, size_t size) {
+            return static_cast<Allocator*>(opaque)->Realloc(ptr, size);
+        };
+        mf.js_malloc_usable_size = +[](const void* ptr) {
+            return Allocator::UsableSize(ptr);
+        };
+        return mf;
+    }();
+    return JS_NewRuntime2(&functions, &allocator);
+}
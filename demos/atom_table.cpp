@@ -0,0 +1,115 @@
+#include "atom_table.hpp"
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace detail {
+
+thread_local AtomCache tAtomCache;
+std::atomic<uint64_t> gAtomGeneration{0};
+
+}  // namespace detail
+
+namespace {
+
+// constant initialized, usable by AtomSlot in any static initializer
+std::mutex gAtomMutex;
+std::unordered_map<JSRuntime*, std::unique_ptr<std::vector<JSAtom>>>*
+    gAtomTables;
+
+// names are template parameter objects, they live as long as the program.
+// Built on first use, AtomSlot registers before this file is initialized
+std::vector<std::string_view>& AtomNames() {
+    static std::vector<std::string_view> names;
+    return names;
+}
+
+void DropAtomTable(JSRuntime* runtime, void*) {
+    // atoms themselves are freed with the runtime's atom table
+    std::lock_guard lock{gAtomMutex};
+    gAtomTables->erase(runtime);
+    // a new runtime may get the same address, drop all thread caches
+    detail::gAtomGeneration.fetch_add(1, std::memory_order_release);
+}
+
+// table of runtime, created (and tied to runtime's lifetime) on first use.
+// Hold gAtomMutex
+std::vector<JSAtom>* GetAtomTable(JSRuntime* runtime) {
+    if (!gAtomTables) {
+        // never freed, finalizers of runtimes may run at exit
+        gAtomTables = new std::unordered_map<
+            JSRuntime*, std::unique_ptr<std::vector<JSAtom>>>;
+    }
+
+    auto& atoms = (*gAtomTables)[runtime];
+    if (!atoms) {
+        if (JS_AddRuntimeFinalizer(runtime, DropAtomTable, nullptr) < 0) {
+            gAtomTables->erase(runtime);
+            return nullptr;
+        }
+        atoms = std::make_unique<std::vector<JSAtom>>();
+    }
+    return atoms.get();
+}
+
+// intern names registered so far which are missing in atoms
+bool InternMissing(JSContext* ctx, std::vector<JSAtom>& atoms) {
+    const auto& names = AtomNames();
+    for (size_t i = atoms.size(); i < names.size(); i++) {
+        JSAtom atom = JS_NewAtomLen(ctx, names[i].data(), names[i].size());
+        if (atom == JS_ATOM_NULL) {
+            return false;
+        }
+        atoms.push_back(atom);
+    }
+    return true;
+}
+
+}  // namespace
+
+bool InternAtoms(JSRuntime* runtime) {
+    // atoms belong to runtime, a raw context is enough to create them
+    JSContext* ctx = JS_NewContextRaw(runtime);
+    if (!ctx) {
+        std::cerr << "create context for atoms failed" << std::endl;
+        return false;
+    }
+
+    bool success;
+    {
+        std::lock_guard lock{gAtomMutex};
+        std::vector<JSAtom>* atoms = GetAtomTable(runtime);
+        success = atoms && InternMissing(ctx, *atoms);
+    }
+    JS_FreeContext(ctx);
+    return success;
+}
+
+namespace detail {
+
+uint32_t RegisterAtomName(const char* name, size_t len) {
+    std::lock_guard lock{gAtomMutex};
+    auto& names = AtomNames();
+    names.emplace_back(name, len);
+    return static_cast<uint32_t>(names.size() - 1);
+}
+
+JSAtom LookupAtom(JSContext* ctx, uint32_t index) {
+    JSRuntime* runtime = JS_GetRuntime(ctx);
+
+    std::lock_guard lock{gAtomMutex};
+    std::vector<JSAtom>* atoms = GetAtomTable(runtime);
+    // all names registered so far, not only the requested one
+    if (!atoms || !InternMissing(ctx, *atoms)) {
+        return JS_ATOM_NULL;
+    }
+
+    tAtomCache.runtime = runtime;
+    tAtomCache.generation = gAtomGeneration.load(std::memory_order_acquire);
+    tAtomCache.atoms = atoms;
+    return (*atoms)[index];
+}
+
+}  // namespace detail
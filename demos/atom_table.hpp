@@ -0,0 +1,113 @@
+#pragma once
+
+#include "quickjs.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* per-runtime table of atoms named at compile time:
+ *
+ *   JSValue stack = JS_GetProperty(ctx, error, Atom<"stack">(ctx));
+ *
+ * every name used by Atom<> anywhere in the program is registered before
+ * main, InternAtoms(runtime) interns all of them when the runtime is created
+ * (otherwise the first Atom<> of a runtime does). Later lookups are a
+ * thread-local compare & vector index instead of hashing the string like
+ * the *Str APIs (compare with JS_NewAtom/JS_FreeAtom in
+ * demos/03-BindingGlobalFields)
+ *
+ * atoms are borrowed, don't JS_FreeAtom them. The table is dropped by a
+ * finalizer of the runtime (JS_AddRuntimeFinalizer), nothing to release
+ */
+
+// string literal as template parameter
+template <size_t N>
+struct AtomName {
+    char value[N];
+
+    constexpr AtomName(const char (&str)[N]) {
+        for (size_t i = 0; i < N; i++) {
+            value[i] = str[i];
+        }
+    }
+};
+
+/* intern all names of the program in runtime, call it right after
+ * JS_NewRuntime to keep it out of the first request. false when failed
+ */
+bool InternAtoms(JSRuntime* runtime);
+
+namespace detail {
+
+struct AtomCache {
+    JSRuntime* runtime = nullptr;
+    uint64_t generation = 0;
+    const std::vector<JSAtom>* atoms = nullptr;
+};
+
+// last runtime used by this thread, invalidated when any table is dropped
+extern thread_local AtomCache tAtomCache;
+extern std::atomic<uint64_t> gAtomGeneration;
+
+uint32_t RegisterAtomName(const char* name, size_t len);
+
+// index of Name in every table, registered during static initialization
+template <AtomName Name>
+struct AtomSlot {
+    static inline const uint32_t index =
+        RegisterAtomName(Name.value, sizeof(Name.value) - 1);
+};
+
+// intern missing names of runtime & refresh cache, JS_ATOM_NULL when failed
+JSAtom LookupAtom(JSContext* ctx, uint32_t index);
+
+}  // namespace detail
+
+// don't call it from static initializers, names may not be registered yet
+template <AtomName Name>
+JSAtom Atom(JSContext* ctx) {
+    const uint32_t index = detail::AtomSlot<Name>::index;
+
+    const detail::AtomCache& cache = detail::tAtomCache;
+    if (cache.runtime == JS_GetRuntime(ctx) &&
+        cache.generation ==
+            detail::gAtomGeneration.load(std::memory_order_acquire) &&
+        index < cache.atoms->size()) {
+        return (*cache.atoms)[index];
+    }
+    return detail::LookupAtom(ctx, index);
+}
+
+// obj[Name], like JS_GetPropertyStr
+template <AtomName Name>
+JSValue GetProperty(JSContext* ctx, JSValueConst obj) {
+    JSAtom atom = Atom<Name>(ctx);
+    if (atom == JS_ATOM_NULL) {
+        return JS_EXCEPTION;
+    }
+    return JS_GetProperty(ctx, obj, atom);
+}
+
+// obj[Name] = value, like JS_SetPropertyStr (take ownership of value)
+template <AtomName Name>
+int SetProperty(JSContext* ctx, JSValueConst obj, JSValue value) {
+    JSAtom atom = Atom<Name>(ctx);
+    if (atom == JS_ATOM_NULL) {
+        JS_FreeValue(ctx, value);
+        return -1;
+    }
+    return JS_SetProperty(ctx, obj, atom, value);
+}
+
+// obj[Name] defined with flags, like JS_DefinePropertyValueStr
+template <AtomName Name>
+int DefineProperty(JSContext* ctx, JSValueConst obj, JSValue value,
+                   int flags) {
+    JSAtom atom = Atom<Name>(ctx);
+    if (atom == JS_ATOM_NULL) {
+        JS_FreeValue(ctx, value);
+        return -1;
+    }
+    return JS_DefinePropertyValue(ctx, obj, atom, value, flags);
+}
@@ -0,0 +1,953 @@
+#pragma once
+
+#include "atom_table.hpp"
+#include "memory_telemetry.hpp"
+#include "native_profiler.hpp"
+#include "object_pool.hpp"
+#include "quickjs.h"
+#include "typed_array.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/* compile-time binding helpers
+ *
+ * `BindFunction<&Add>(ctx, "Add")` deduces parameter & return types from the
+ * C++ signature and instantiates one thunk per signature, so the per-call
+ * work is only the conversions that signature really needs (compare with
+ * `AddFnBinding` in demos/04-BindingGlobalFunctions)
+ *
+ * every thunk is profiled when its runtime is (see native_profiler.hpp)
+ */
+
+/************************* value conversion *************************/
+
+// specialize JSConverter<T> to make T usable in bound signatures:
+//   static bool FromJS(JSContext*, JSValueConst, T& out); // false: exception
+//   static JSValue ToJS(JSContext*, const T&);
+template <typename T, typename = void>
+struct JSConverter;
+
+template <>
+struct JSConverter<bool> {
+    static bool FromJS(JSContext* ctx, JSValueConst value, bool& out) {
+        if (JS_VALUE_GET_TAG(value) == JS_TAG_BOOL) {
+            out = JS_VALUE_GET_BOOL(value);
+            return true;
+        }
+        int result = JS_ToBool(ctx, value);
+        out = result > 0;
+        return result >= 0;
+    }
+
+    static JSValue ToJS(JSContext* ctx, bool value) {
+        return JS_NewBool(ctx, value);
+    }
+};
+
+// integral types which fit in int32 (int8 ~ int32, uint8, uint16)
+template <typename T>
+struct JSConverter<
+    T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+                        (sizeof(T) < 4 || (sizeof(T) == 4 &&
+                                           std::is_signed_v<T>))>> {
+    static bool FromJS(JSContext* ctx, JSValueConst value, T& out) {
+        // fast path: small integer is stored directly in JSValue
+        if (JS_VALUE_GET_TAG(value) == JS_TAG_INT) {
+            out = static_cast<T>(JS_VALUE_GET_INT(value));
+            return true;
+        }
+        int32_t result;
+        if (JS_ToInt32(ctx, &result, value) < 0) {
+            return false;
+        }
+        out = static_cast<T>(result);
+        return true;
+    }
+
+    static JSValue ToJS(JSContext* ctx, T value) {
+        return JS_NewInt32(ctx, value);
+    }
+};
+
+template <>
+struct JSConverter<uint32_t> {
+    static bool FromJS(JSContext* ctx, JSValueConst value, uint32_t& out) {
+        if (JS_VALUE_GET_TAG(value) == JS_TAG_INT) {
+            out = static_cast<uint32_t>(JS_VALUE_GET_INT(value));
+            return true;
+        }
+        return JS_ToUint32(ctx, &out, value) == 0;
+    }
+
+    static JSValue ToJS(JSContext* ctx, uint32_t value) {
+        return JS_NewUint32(ctx, value);
+    }
+};
+
+// 64bit integral types
+template <typename T>
+struct JSConverter<T, std::enable_if_t<std::is_integral_v<T> &&
+                                       !std::is_same_v<T, bool> &&
+                                       sizeof(T) == 8>> {
+    static bool FromJS(JSContext* ctx, JSValueConst value, T& out) {
+        if (JS_VALUE_GET_TAG(value) == JS_TAG_INT) {
+            out = static_cast<T>(JS_VALUE_GET_INT(value));
+            return true;
+        }
+        int64_t result;
+        if (JS_ToInt64(ctx, &result, value) < 0) {
+            return false;
+        }
+        out = static_cast<T>(result);
+        return true;
+    }
+
+    static JSValue ToJS(JSContext* ctx, T value) {
+        return JS_NewInt64(ctx, static_cast<int64_t>(value));
+    }
+};
+
+template <typename T>
+struct JSConverter<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+    static bool FromJS(JSContext* ctx, JSValueConst value, T& out) {
+        // fast path: number is already a double or a small integer
+        int tag = JS_VALUE_GET_NORM_TAG(value);
+        if (tag == JS_TAG_FLOAT64) {
+            out = static_cast<T>(JS_VALUE_GET_FLOAT64(value));
+            return true;
+        }
+        if (tag == JS_TAG_INT) {
+            out = static_cast<T>(JS_VALUE_GET_INT(value));
+            return true;
+        }
+        double result;
+        if (JS_ToFloat64(ctx, &result, value) < 0) {
+            return false;
+        }
+        out = static_cast<T>(result);
+        return true;
+    }
+
+    static JSValue ToJS(JSContext* ctx, T value) {
+        return JS_NewFloat64(ctx, static_cast<double>(value));
+    }
+};
+
+template <>
+struct JSConverter<std::string> {
+    static bool FromJS(JSContext* ctx, JSValueConst value, std::string& out) {
+        size_t len;
+        const char* str = JS_ToCStringLen(ctx, &len, value);
+        if (!str) {
+            return false;
+        }
+        out.assign(str, len);
+        JS_FreeCString(ctx, str);
+        return true;
+    }
+
+    static JSValue ToJS(JSContext* ctx, const std::string& value) {
+        return JS_NewStringLen(ctx, value.data(), value.size());
+    }
+};
+
+// only as return type, string_view/const char* parameters use ArgHolder
+template <>
+struct JSConverter<std::string_view> {
+    static JSValue ToJS(JSContext* ctx, std::string_view value) {
+        return JS_NewStringLen(ctx, value.data(), value.size());
+    }
+};
+
+template <>
+struct JSConverter<const char*> {
+    static JSValue ToJS(JSContext* ctx, const char* value) {
+        return JS_NewString(ctx, value);
+    }
+};
+
+// raw JSValue is passed through, returned JSValue must be owned by caller
+template <>
+struct JSConverter<JSValue> {
+    static bool FromJS(JSContext*, JSValueConst value, JSValue& out) {
+        out = value;
+        return true;
+    }
+
+    static JSValue ToJS(JSContext*, JSValue value) { return value; }
+};
+
+/* TypedArray parameter viewing script memory without copy (see
+ * typed_array.hpp), only valid during the call. Not usable as return type:
+ * return NewTypedArrayView/NewOwningTypedArray as JSValue instead
+ */
+template <typename T>
+struct JSConverter<
+    std::span<T>,
+    std::enable_if_t<(TypedArrayType<std::remove_cv_t<T>> >= 0)>> {
+    static bool FromJS(JSContext* ctx, JSValueConst value,
+                       std::span<T>& out) {
+        return GetTypedArraySpan(ctx, value, out);
+    }
+};
+
+/************************* argument storage *************************/
+
+// keep converted argument alive until the bound function returns
+template <typename T>
+struct ArgHolder {
+    T value{};
+
+    bool Load(JSContext* ctx, JSValueConst js_value) {
+        return JSConverter<T>::FromJS(ctx, js_value, value);
+    }
+
+    T& Get() { return value; }
+};
+
+// borrow string from quickjs without copy, release it after call
+template <>
+struct ArgHolder<std::string_view> {
+    JSContext* ctx = nullptr;
+    const char* str = nullptr;
+    size_t len = 0;
+
+    ArgHolder() = default;
+    ArgHolder(const ArgHolder&) = delete;
+    ArgHolder& operator=(const ArgHolder&) = delete;
+
+    ~ArgHolder() {
+        if (str) {
+            JS_FreeCString(ctx, str);
+        }
+    }
+
+    bool Load(JSContext* ctx, JSValueConst js_value) {
+        this->ctx = ctx;
+        str = JS_ToCStringLen(ctx, &len, js_value);
+        return str != nullptr;
+    }
+
+    std::string_view Get() const { return {str, len}; }
+};
+
+template <>
+struct ArgHolder<const char*> : ArgHolder<std::string_view> {
+    const char* Get() const { return str; }
+};
+
+/************************* function traits *************************/
+
+template <typename T>
+struct FunctionTraits;
+
+template <typename R, typename... Args>
+struct FunctionTraits<R (*)(Args...)> {
+    using return_type = R;
+    using args_type = std::tuple<Args...>;
+    static constexpr size_t arg_count = sizeof...(Args);
+};
+
+template <typename R, typename... Args>
+struct FunctionTraits<R (*)(Args...) noexcept>
+    : FunctionTraits<R (*)(Args...)> {};
+
+// member functions, `this` is not counted in args_type
+template <typename R, typename C, typename... Args>
+struct FunctionTraits<R (C::*)(Args...)> : FunctionTraits<R (*)(Args...)> {
+    using class_type = C;
+};
+
+template <typename R, typename C, typename... Args>
+struct FunctionTraits<R (C::*)(Args...) const>
+    : FunctionTraits<R (C::*)(Args...)> {};
+
+template <typename R, typename C, typename... Args>
+struct FunctionTraits<R (C::*)(Args...) noexcept>
+    : FunctionTraits<R (C::*)(Args...)> {};
+
+template <typename R, typename C, typename... Args>
+struct FunctionTraits<R (C::*)(Args...) const noexcept>
+    : FunctionTraits<R (C::*)(Args...)> {};
+
+namespace detail {
+
+// captureless lambda -> function pointer, function pointer is kept as is
+template <typename F>
+constexpr auto ToFunctionPointer(F fn) {
+    if constexpr (std::is_class_v<F>) {
+        return +fn;
+    } else {
+        return fn;
+    }
+}
+
+template <typename Tuple>
+struct AllFloatingPoint;
+
+template <typename... Args>
+struct AllFloatingPoint<std::tuple<Args...>>
+    : std::conjunction<std::is_floating_point<Args>...> {};
+
+template <auto Fn>
+using FnTraits = FunctionTraits<decltype(ToFunctionPointer(Fn))>;
+
+/* functions like double(double) & double(double, double) can use
+ * JS_CFUNC_f_f/JS_CFUNC_f_f_f, quickjs call them without boxing argv
+ */
+template <auto Fn, size_t ArgCount>
+constexpr bool IsFloatFn() {
+    using traits = FnTraits<Fn>;
+    return traits::arg_count == ArgCount &&
+           std::is_floating_point_v<typename traits::return_type> &&
+           AllFloatingPoint<typename traits::args_type>::value;
+}
+
+template <auto Fn>
+double FFAdapter(double param) {
+    return static_cast<double>(Fn(param));
+}
+
+template <auto Fn>
+double FFFAdapter(double param1, double param2) {
+    return static_cast<double>(Fn(param1, param2));
+}
+
+// `const std::string&` -> std::string, `int` -> int ...
+template <typename T>
+using StorageType = std::remove_cv_t<std::remove_reference_t<T>>;
+
+template <typename T>
+JSValue ReturnToJS(JSContext* ctx, T&& value) {
+    return JSConverter<StorageType<T>>::ToJS(ctx, std::forward<T>(value));
+}
+
+template <auto Fn, typename R, typename ArgsTuple, size_t... I,
+          typename... Self>
+JSValue CallWithJSArgsImpl(JSContext* ctx, JSValueConst* argv,
+                           std::index_sequence<I...>, Self*... self) {
+    std::tuple<ArgHolder<StorageType<std::tuple_element_t<I, ArgsTuple>>>...>
+        args;
+    // short-circuit: stop at the first argument which throws
+    if (!(std::get<I>(args).Load(ctx, argv[I]) && ...)) {
+        return JS_EXCEPTION;
+    }
+    ProfileArgumentsLoaded();
+
+    // self is empty for free functions, object pointer for member functions
+    if constexpr (std::is_void_v<R>) {
+        std::invoke(Fn, self..., std::get<I>(args).Get()...);
+        return JS_UNDEFINED;
+    } else {
+        return ReturnToJS(ctx,
+                          std::invoke(Fn, self..., std::get<I>(args).Get()...));
+    }
+}
+
+template <auto Fn, typename R, typename... Args, typename... Self>
+JSValue CallWithJSArgs(JSContext* ctx, JSValueConst* argv,
+                       std::tuple<Args...>*, Self*... self) {
+    return CallWithJSArgsImpl<Fn, R, std::tuple<Args...>>(
+        ctx, argv, std::index_sequence_for<Args...>{}, self...);
+}
+
+template <typename T>
+constexpr bool IsTypedArrayElement = TypedArrayType<StorageType<T>> >= 0;
+
+template <typename Tuple>
+struct AllTypedArrayElements;
+
+template <typename... Args>
+struct AllTypedArrayElements<std::tuple<Args...>>
+    : std::bool_constant<(IsTypedArrayElement<Args> && ...)> {};
+
+// numbers in, number out: can run over TypedArrays
+template <auto Fn>
+constexpr bool IsBatchFn() {
+    using traits = FnTraits<Fn>;
+    return traits::arg_count > 0 &&
+           IsTypedArrayElement<typename traits::return_type> &&
+           AllTypedArrayElements<typename traits::args_type>::value;
+}
+
+template <auto Fn, typename R, typename... Args, size_t... I>
+JSValue CallBatchImpl(JSContext* ctx, JSValueConst* argv,
+                      std::index_sequence<I...>) {
+    constexpr size_t output_index = sizeof...(Args);
+
+    std::tuple<std::span<const StorageType<Args>>...> inputs;
+    std::span<StorageType<R>> output;
+    if (!(GetTypedArraySpan(ctx, argv[I], std::get<I>(inputs)) && ...) ||
+        !GetTypedArraySpan(ctx, argv[output_index], output)) {
+        return JS_EXCEPTION;
+    }
+
+    size_t count = output.size();
+    if (((std::get<I>(inputs).size() != count) || ...)) {
+        return JS_ThrowRangeError(ctx, "batch arrays have different length");
+    }
+    ProfileArgumentsLoaded();
+
+    // raw pointers & direct call of Fn, so the loop can be inlined/vectorized
+    std::tuple<const StorageType<Args>*...> in{std::get<I>(inputs).data()...};
+    StorageType<R>* out = output.data();
+    for (size_t i = 0; i < count; i++) {
+        out[i] = static_cast<StorageType<R>>(
+            std::invoke(Fn, std::get<I>(in)[i]...));
+    }
+    return JS_DupValue(ctx, argv[output_index]);
+}
+
+template <auto Fn, typename R, typename... Args>
+JSValue CallBatch(JSContext* ctx, JSValueConst* argv, std::tuple<Args...>*) {
+    return CallBatchImpl<Fn, R, Args...>(ctx, argv,
+                                         std::index_sequence_for<Args...>{});
+}
+
+}  // namespace detail
+
+/************************* thunk & registration *************************/
+
+// JSCFunction generated from Fn's signature
+template <auto Fn>
+JSValue FnThunk(JSContext* ctx, JSValueConst, int argc, JSValueConst* argv) {
+    using traits = detail::FnTraits<Fn>;
+    ProfileScope<&FnThunk<Fn>> scope{ctx};
+
+    if (argc < static_cast<int>(traits::arg_count)) {
+        return JS_ThrowTypeError(ctx, "expect %d arguments but got %d",
+                                 static_cast<int>(traits::arg_count), argc);
+    }
+
+    return detail::CallWithJSArgs<Fn, typename traits::return_type>(
+        ctx, argv, static_cast<typename traits::args_type*>(nullptr));
+}
+
+/* vectorized variant of scalar Fn: `Add.batch(aArr, bArr, outArr)` call Fn
+ * on every element of the input TypedArrays in one tight C++ loop (which
+ * the compiler can vectorize) and return outArr, so a whole batch cross
+ * the JS/C++ boundary only once. Element types must match Fn's signature
+ * exactly (int -> Int32Array, float -> Float32Array ...)
+ */
+template <auto Fn>
+JSValue BatchThunk(JSContext* ctx, JSValueConst, int argc,
+                   JSValueConst* argv) {
+    using traits = detail::FnTraits<Fn>;
+    ProfileScope<&BatchThunk<Fn>> scope{ctx};
+
+    if (argc < static_cast<int>(traits::arg_count + 1)) {
+        return JS_ThrowTypeError(ctx, "expect %d arrays but got %d",
+                                 static_cast<int>(traits::arg_count + 1),
+                                 argc);
+    }
+
+    return detail::CallBatch<Fn, typename traits::return_type>(
+        ctx, argv, static_cast<typename traits::args_type*>(nullptr));
+}
+
+namespace detail {
+
+template <auto Fn>
+JSValue NewScalarFunction(JSContext* ctx, const char* name) {
+    using traits = FnTraits<Fn>;
+    using fn_type_t = decltype(ToFunctionPointer(Fn));
+
+    if (IsProfiling(ctx)) {
+        NameProfileSite(ProfileKey(FnThunk<Fn>), name);
+        // quickjs calls JS_CFUNC_f_f directly, no thunk to profile
+        return JS_NewCFunction(ctx, FnThunk<Fn>, name,
+                               static_cast<int>(traits::arg_count));
+    }
+
+    // see BindFF/BindFFF in demos/04-BindingGlobalFunctions
+    JSCFunctionType fn_type;
+    if constexpr (IsFloatFn<Fn, 1>()) {
+        if constexpr (std::is_convertible_v<fn_type_t, double (*)(double)>) {
+            fn_type.f_f = ToFunctionPointer(Fn);
+        } else {
+            fn_type.f_f = FFAdapter<Fn>;
+        }
+        return JS_NewCFunction2(ctx, fn_type.generic, name, 1, JS_CFUNC_f_f,
+                                0);
+    } else if constexpr (IsFloatFn<Fn, 2>()) {
+        if constexpr (std::is_convertible_v<fn_type_t,
+                                            double (*)(double, double)>) {
+            fn_type.f_f_f = ToFunctionPointer(Fn);
+        } else {
+            fn_type.f_f_f = FFFAdapter<Fn>;
+        }
+        return JS_NewCFunction2(ctx, fn_type.generic, name, 2, JS_CFUNC_f_f_f,
+                                0);
+    } else {
+        return JS_NewCFunction(ctx, FnThunk<Fn>, name,
+                               static_cast<int>(traits::arg_count));
+    }
+}
+
+}  // namespace detail
+
+/* Fn can be function pointer or captureless lambda.
+ * floating point functions with one/two parameters are registered as
+ * JS_CFUNC_f_f/JS_CFUNC_f_f_f automatically (missing arguments become NaN
+ * like Math.xxx rather than throwing), others use FnThunk.
+ * functions over numbers also get `fn.batch` (see BatchThunk)
+ */
+template <auto Fn>
+JSValue NewFunction(JSContext* ctx, const char* name) {
+    JSValue fn = detail::NewScalarFunction<Fn>(ctx, name);
+    if constexpr (detail::IsBatchFn<Fn>()) {
+        if (JS_IsException(fn)) {
+            return fn;
+        }
+
+        using traits = detail::FnTraits<Fn>;
+        if (detail::IsProfiling(ctx)) {
+            NameProfileSite(detail::ProfileKey(BatchThunk<Fn>),
+                            std::string{name} + ".batch");
+        }
+        JSValue batch =
+            JS_NewCFunction(ctx, BatchThunk<Fn>, "batch",
+                            static_cast<int>(traits::arg_count + 1));
+        // interned once per runtime, see atom_table.hpp
+        int ret = DefineProperty<"batch">(ctx, fn, batch, JS_PROP_CONFIGURABLE);
+        if (ret < 0) {
+            JS_FreeValue(ctx, fn);
+            return JS_EXCEPTION;
+        }
+    }
+    return fn;
+}
+
+// bind Fn to obj[name], return false when failed (exception is pending)
+template <auto Fn>
+bool BindFunction(JSContext* ctx, JSValueConst obj, const char* name) {
+    JSValue fn = NewFunction<Fn>(ctx, name);
+    if (JS_IsException(fn)) {
+        return false;
+    }
+    return JS_DefinePropertyValueStr(ctx, obj, name, fn, JS_PROP_C_W_E) >= 0;
+}
+
+// bind Fn to globalThis[name]
+template <auto Fn>
+bool BindFunction(JSContext* ctx, const char* name) {
+    JSValue global_this = JS_GetGlobalObject(ctx);
+    bool success = BindFunction<Fn>(ctx, global_this, name);
+    JS_FreeValue(ctx, global_this);
+    return success;
+}
+
+/************************* magic function table *************************/
+
+/* gather many functions behind one JSCFunctionMagic, magic is the index in
+ * a constexpr jump table (compare with the if/else chain of BindMagicFn in
+ * demos/04-BindingGlobalFunctions):
+ *
+ *   using EngineFns = MagicFunctionTable<&Fn1, &Fn2>;
+ *   // lifetime must longer than script, like `entries` in demos/05
+ *   const auto gEngineEntries = EngineFns::MakeEntries({"fn1", "fn2"});
+ *   JS_SetPropertyFunctionList(ctx, obj, gEngineEntries.data(),
+ *                              gEngineEntries.size());
+ */
+template <auto... Fns>
+struct MagicFunctionTable {
+    static constexpr size_t size = sizeof...(Fns);
+    static_assert(size > 0 && size <= INT16_MAX,
+                  "magic is stored as int16 in JSCFunctionListEntry");
+
+    static JSValue Thunk(JSContext* ctx, JSValueConst self, int argc,
+                         JSValueConst* argv, int magic) {
+        // instantiate the registration together with the thunk
+        static_cast<void>(sProfileSites);
+        if (static_cast<unsigned>(magic) >= size) {
+            return JS_ThrowInternalError(ctx, "invalid magic %d", magic);
+        }
+        return sTable[magic](ctx, self, argc, argv);
+    }
+
+    static constexpr std::array<JSCFunctionListEntry, size> MakeEntries(
+        const char* const (&names)[size]) {
+        return MakeEntries(names, std::make_index_sequence<size>{});
+    }
+
+    // create single function object, like JS_NewCFunctionMagic in
+    // demos/04-BindingGlobalFunctions
+    static JSValue NewFunction(JSContext* ctx, const char* name, int magic) {
+        constexpr int lengths[] = {
+            static_cast<int>(detail::FnTraits<Fns>::arg_count)...};
+        if (static_cast<unsigned>(magic) >= size) {
+            return JS_ThrowInternalError(ctx, "invalid magic %d", magic);
+        }
+        if (detail::IsProfiling(ctx)) {
+            NameProfileSite(detail::ProfileKey(sTable[magic]), name);
+        }
+        return JS_NewCFunctionMagic(ctx, Thunk, name, lengths[magic],
+                                    JS_CFUNC_generic_magic, magic);
+    }
+
+    // name functions of MakeEntries in profile reports
+    static void NameProfileSites(const char* const (&names)[size]) {
+        for (size_t i = 0; i < size; i++) {
+            NameProfileSite(detail::ProfileKey(sTable[i]), names[i]);
+        }
+    }
+
+private:
+    static constexpr JSCFunction* sTable[] = {FnThunk<Fns>...};
+    // lets NameProfileSites (ClassBinder::Register) see through Thunk
+    static inline const bool sProfileSites =
+        detail::RegisterMagicProfileSites(Thunk, sTable, size);
+
+    template <size_t... I>
+    static constexpr std::array<JSCFunctionListEntry, size> MakeEntries(
+        const char* const (&names)[size], std::index_sequence<I...>) {
+        return {{JS_CFUNC_MAGIC_DEF(
+            names[I], static_cast<uint8_t>(detail::FnTraits<Fns>::arg_count),
+            Thunk, static_cast<int16_t>(I))...}};
+    }
+};
+
+/************************* class binding *************************/
+
+template <typename T>
+struct MemberPointerTraits;
+
+template <typename C, typename F>
+struct MemberPointerTraits<F C::*> {
+    using class_type = C;
+    using type = F;
+};
+
+/* ClassBinder<T> generate getter/setter/method thunks for T from member
+ * pointers, each thunk access the member at compile-time offset (compare
+ * with NameGetter/IntroduceBinding in demos/05-BindingClass):
+ *
+ *   // This lifetime must longer than script JSValue
+ *   const JSCFunctionListEntry gPersonEntries[] = {
+ *       ClassBinder<Person>::Field<&Person::age>("age"),
+ *       ClassBinder<Person>::Method<&Person::Introduce>("introduce"),
+ *       ClassBinder<Person>::Property<&Person::GetBMI>("bmi"),
+ *   };
+ *
+ *   // constructor arguments are listed as template parameters
+ *   JSValue ctor = ClassBinder<Person>::Register<std::string, float, int>(
+ *       runtime, ctx, "Person", gPersonEntries, std::size(gPersonEntries));
+ *
+ * native objects are created/destroyed by ClassAllocator<T> (see
+ * object_pool.hpp) & counted by NativeClassCounter (memory_telemetry.hpp)
+ */
+template <typename T>
+class ClassBinder {
+public:
+    static JSClassID GetClassID() { return sClassID; }
+
+    // get native object, throw TypeError and return nullptr when self is not T
+    static T* Unwrap(JSContext* ctx, JSValueConst self) {
+        return static_cast<T*>(JS_GetOpaque2(ctx, self, sClassID));
+    }
+
+    // data member, read-only when it is const
+    template <auto Member>
+    static constexpr JSCFunctionListEntry Field(const char* name) {
+        using field_type = typename MemberPointerTraits<decltype(Member)>::type;
+        static_assert(!std::is_same_v<std::remove_cv_t<field_type>, JSValue>,
+                      "JSValue field need reference counting, bind it by "
+                      "Property");
+
+        if constexpr (std::is_const_v<field_type>) {
+            return JS_CGETSET_DEF(name, FieldGetter<Member>, nullptr);
+        } else {
+            return JS_CGETSET_DEF(name, FieldGetter<Member>,
+                                  FieldSetter<Member>);
+        }
+    }
+
+    /* contiguous container member (std::vector<float>, float[N] ...) as
+     * TypedArray over its memory, the view keeps `this` alive. Each access
+     * create a new view, so it follows reallocation of the container. Don't
+     * cache the view on the object itself, the GC can't see that cycle
+     */
+    template <auto Member>
+    static constexpr JSCFunctionListEntry Buffer(const char* name) {
+        return JS_CGETSET_DEF(name, BufferGetter<Member>, nullptr);
+    }
+
+    // member function
+    template <auto Fn>
+    static constexpr JSCFunctionListEntry Method(const char* name) {
+        return JS_CFUNC_DEF(
+            name, static_cast<uint8_t>(FunctionTraits<decltype(Fn)>::arg_count),
+            MethodThunk<Fn>);
+    }
+
+    // accessor by member functions, read-only when Setter is nullptr
+    template <auto Getter, auto Setter = nullptr>
+    static constexpr JSCFunctionListEntry Property(const char* name) {
+        if constexpr (std::is_null_pointer_v<decltype(Setter)>) {
+            return JS_CGETSET_DEF(name, PropertyGetter<Getter>, nullptr);
+        } else {
+            return JS_CGETSET_DEF(name, PropertyGetter<Getter>,
+                                  PropertySetter<Setter>);
+        }
+    }
+
+    /* register class to runtime & create its prototype in ctx, return
+     * constructor which call T(Args...) (JS_EXCEPTION when failed)
+     */
+    template <typename... Args>
+    static JSValue Register(JSRuntime* runtime, JSContext* ctx,
+                            const char* class_name,
+                            const JSCFunctionListEntry* entries,
+                            size_t entry_count) {
+        // class id is shared between runtimes, only allocated once
+        JS_NewClassID(runtime, &sClassID);
+        static NativeClassCounter& counter =
+            NativeClassCounter::Get(class_name, sizeof(T));
+        sCounter.store(&counter, std::memory_order_release);
+        if (!JS_IsRegisteredClass(runtime, sClassID)) {
+            // don't forget zero-initialize
+            JSClassDef def{};
+            def.class_name = class_name;
+            def.finalizer = Finalizer;
+            if (JS_NewClass(runtime, sClassID, &def) < 0) {
+                return JS_ThrowInternalError(ctx, "create class %s failed",
+                                             class_name);
+            }
+        }
+
+        if (detail::IsProfiling(ctx)) {
+            NameProfileSite(detail::ProfileKey(ConstructorThunk<Args...>),
+                            std::string{"new "} + class_name);
+            NameProfileSites(std::string{class_name} + ".", entries,
+                             entry_count);
+        }
+
+        JSValue proto = JS_NewObject(ctx);
+        if (JS_IsException(proto)) {
+            return proto;
+        }
+        if (JS_SetPropertyFunctionList(ctx, proto, entries,
+                                       static_cast<int>(entry_count)) < 0) {
+            JS_FreeValue(ctx, proto);
+            return JS_EXCEPTION;
+        }
+
+        JSValue constructor = JS_NewCFunction2(
+            ctx, ConstructorThunk<Args...>, class_name,
+            static_cast<int>(sizeof...(Args)), JS_CFUNC_constructor, 0);
+        if (JS_IsException(constructor)) {
+            JS_FreeValue(ctx, proto);
+            return constructor;
+        }
+
+        // link constructor.prototype & prototype.constructor
+        JS_SetConstructor(ctx, constructor, proto);
+        // class proto take the ownership of proto
+        JS_SetClassProto(ctx, sClassID, proto);
+        return constructor;
+    }
+
+private:
+    static inline JSClassID sClassID = 0;
+    // set by first Register, objects can't be created before that
+    static inline std::atomic<NativeClassCounter*> sCounter{nullptr};
+
+    template <auto Member>
+    static JSValue FieldGetter(JSContext* ctx, JSValueConst self) {
+        using field_type = std::remove_cv_t<
+            typename MemberPointerTraits<decltype(Member)>::type>;
+        ProfileScope<&FieldGetter<Member>> scope{ctx};
+
+        T* obj = Unwrap(ctx, self);
+        if (!obj) {
+            return JS_EXCEPTION;
+        }
+
+        if constexpr (std::is_array_v<field_type>) {
+            // char buffer like Person::name
+            return JS_NewString(ctx, obj->*Member);
+        } else {
+            return JSConverter<field_type>::ToJS(ctx, obj->*Member);
+        }
+    }
+
+    template <auto Member>
+    static JSValue FieldSetter(JSContext* ctx, JSValueConst self,
+                               JSValueConst value) {
+        using field_type = typename MemberPointerTraits<decltype(Member)>::type;
+        ProfileScope<&FieldSetter<Member>> scope{ctx};
+
+        T* obj = Unwrap(ctx, self);
+        if (!obj) {
+            return JS_EXCEPTION;
+        }
+
+        if constexpr (std::is_array_v<field_type>) {
+            static_assert(
+                std::is_same_v<std::remove_extent_t<field_type>, char>,
+                "only char array field is supported");
+            size_t len;
+            const char* str = JS_ToCStringLen(ctx, &len, value);
+            if (!str) {
+                return JS_EXCEPTION;
+            }
+            // truncate to buffer size
+            char* buf = obj->*Member;
+            len = std::min(len, std::extent_v<field_type> - 1);
+            memcpy(buf, str, len);
+            buf[len] = '\0';
+            JS_FreeCString(ctx, str);
+        } else if (!JSConverter<field_type>::FromJS(ctx, value,
+                                                    obj->*Member)) {
+            return JS_EXCEPTION;
+        }
+        return JS_UNDEFINED;
+    }
+
+    template <auto Member>
+    static JSValue BufferGetter(JSContext* ctx, JSValueConst self) {
+        ProfileScope<&BufferGetter<Member>> scope{ctx};
+        T* obj = Unwrap(ctx, self);
+        if (!obj) {
+            return JS_EXCEPTION;
+        }
+
+        auto& container = obj->*Member;
+        return NewTypedArrayView(
+            ctx, std::span{std::data(container), std::size(container)}, self);
+    }
+
+    template <auto Fn>
+    static JSValue MethodThunk(JSContext* ctx, JSValueConst self, int argc,
+                               JSValueConst* argv) {
+        using traits = FunctionTraits<decltype(Fn)>;
+        ProfileScope<&MethodThunk<Fn>> scope{ctx};
+
+        T* obj = Unwrap(ctx, self);
+        if (!obj) {
+            return JS_EXCEPTION;
+        }
+
+        if (argc < static_cast<int>(traits::arg_count)) {
+            return JS_ThrowTypeError(ctx, "expect %d arguments but got %d",
+                                     static_cast<int>(traits::arg_count), argc);
+        }
+
+        return detail::CallWithJSArgs<Fn, typename traits::return_type>(
+            ctx, argv, static_cast<typename traits::args_type*>(nullptr), obj);
+    }
+
+    template <auto Getter>
+    static JSValue PropertyGetter(JSContext* ctx, JSValueConst self) {
+        ProfileScope<&PropertyGetter<Getter>> scope{ctx};
+        T* obj = Unwrap(ctx, self);
+        if (!obj) {
+            return JS_EXCEPTION;
+        }
+        return detail::ReturnToJS(ctx, std::invoke(Getter, obj));
+    }
+
+    template <auto Setter>
+    static JSValue PropertySetter(JSContext* ctx, JSValueConst self,
+                                  JSValueConst value) {
+        using traits = FunctionTraits<decltype(Setter)>;
+        static_assert(traits::arg_count == 1, "setter must has one parameter");
+        ProfileScope<&PropertySetter<Setter>> scope{ctx};
+
+        T* obj = Unwrap(ctx, self);
+        if (!obj) {
+            return JS_EXCEPTION;
+        }
+
+        JSValue result = detail::CallWithJSArgs<Setter,
+                                                typename traits::return_type>(
+            ctx, &value, static_cast<typename traits::args_type*>(nullptr),
+            obj);
+        if (JS_IsException(result)) {
+            return result;
+        }
+        // setter's return value is dropped
+        JS_FreeValue(ctx, result);
+        return JS_UNDEFINED;
+    }
+
+    // object of class with new_target's prototype, so JS subclasses work
+    static JSValue NewInstance(JSContext* ctx, JSValueConst new_target) {
+        JSValue proto = GetProperty<"prototype">(ctx, new_target);
+        if (JS_IsException(proto)) {
+            return proto;
+        }
+        // like quickjs: fall back to the class prototype
+        JSValue result = JS_IsObject(proto)
+                             ? JS_NewObjectProtoClass(ctx, proto, sClassID)
+                             : JS_NewObjectClass(ctx, sClassID);
+        JS_FreeValue(ctx, proto);
+        return result;
+    }
+
+    template <typename... Args, size_t... I>
+    static JSValue Construct(JSContext* ctx, JSValueConst new_target,
+                             JSValueConst* argv, std::index_sequence<I...>) {
+        std::tuple<ArgHolder<detail::StorageType<Args>>...> args;
+        if (!(std::get<I>(args).Load(ctx, argv[I]) && ...)) {
+            return JS_EXCEPTION;
+        }
+        ProfileArgumentsLoaded();
+
+        // create JS object first, so no native object leaks when it failed
+        JSValue result = NewInstance(ctx, new_target);
+        if (JS_IsException(result)) {
+            return result;
+        }
+
+        // C++ exceptions must not unwind through quickjs
+        const char* class_name =
+            sCounter.load(std::memory_order_acquire)->ClassName().c_str();
+        T* obj;
+        try {
+            obj = ClassAllocator<T>::New(std::get<I>(args).Get()...);
+        } catch (const std::exception& e) {
+            JS_FreeValue(ctx, result);
+            return JS_ThrowInternalError(ctx, "new %s: %s", class_name,
+                                         e.what());
+        } catch (...) {
+            JS_FreeValue(ctx, result);
+            return JS_ThrowInternalError(ctx, "new %s: unknown exception",
+                                         class_name);
+        }
+        JS_SetOpaque(result, obj);
+        sCounter.load(std::memory_order_acquire)->Add();
+        return result;
+    }
+
+    template <typename... Args>
+    static JSValue ConstructorThunk(JSContext* ctx, JSValueConst new_target,
+                                    int argc, JSValueConst* argv) {
+        ProfileScope<&ConstructorThunk<Args...>> scope{ctx};
+        if (argc < static_cast<int>(sizeof...(Args))) {
+            return JS_ThrowTypeError(ctx, "expect %d arguments but got %d",
+                                     static_cast<int>(sizeof...(Args)), argc);
+        }
+        return Construct<Args...>(ctx, new_target, argv,
+                                  std::index_sequence_for<Args...>{});
+    }
+
+    static void Finalizer(JSRuntime*, JSValue self) {
+        T* obj = static_cast<T*>(JS_GetOpaque(self, sClassID));
+        if (obj) {
+            ClassAllocator<T>::Delete(obj);
+            sCounter.load(std::memory_order_acquire)->Remove();
+        }
+    }
+};
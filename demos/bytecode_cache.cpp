@@ -0,0 +1,252 @@
+#include "bytecode_cache.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+constexpr uint64_t HashSeed = 0xcbf29ce484222325ull;
+
+// FNV-1a 64bit
+uint64_t Hash(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// written before bytecode in cache files, in native byte order
+struct FileHeader {
+    char magic[4];
+    uint32_t format;
+    char quickjs_version[32];  // NUL padded
+    uint64_t size;             // bytes of bytecode after the header
+    uint64_t hash;             // of bytecode
+};
+
+constexpr char FileMagic[4] = {'Q', 'J', 'B', 'C'};
+constexpr uint32_t FileFormat = 1;
+
+FileHeader MakeHeader(const Bytecode& code) {
+    FileHeader header{};
+    memcpy(header.magic, FileMagic, sizeof(FileMagic));
+    header.format = FileFormat;
+    strncpy(header.quickjs_version, JS_GetVersion(),
+            sizeof(header.quickjs_version) - 1);
+    header.size = code.size();
+    header.hash = Hash(HashSeed, code.data(), code.size());
+    return header;
+}
+
+// bytecode of a cache file, nullptr when missing or not written by us
+std::shared_ptr<const Bytecode> ReadCacheFile(const std::string& path) {
+    std::error_code err;
+    uintmax_t file_size = std::filesystem::file_size(path, err);
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (err || !file) {
+        return nullptr;
+    }
+
+    FileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        std::cerr << "bytecode cache " << path << " is truncated" << std::endl;
+        return nullptr;
+    }
+    FileHeader expected{};
+    strncpy(expected.quickjs_version, JS_GetVersion(),
+            sizeof(expected.quickjs_version) - 1);
+    if (memcmp(header.magic, FileMagic, sizeof(FileMagic)) != 0 ||
+        header.format != FileFormat ||
+        memcmp(header.quickjs_version, expected.quickjs_version,
+               sizeof(header.quickjs_version)) != 0) {
+        std::cerr << "bytecode cache " << path
+                  << " is written by another version" << std::endl;
+        return nullptr;
+    }
+
+    // check length before allocating it
+    if (header.size != file_size - sizeof(header)) {
+        std::cerr << "bytecode cache " << path << " is damaged" << std::endl;
+        return nullptr;
+    }
+    auto code = std::make_shared<Bytecode>(header.size);
+    if (!file.read(reinterpret_cast<char*>(code->data()), code->size()) ||
+        Hash(HashSeed, code->data(), code->size()) != header.hash) {
+        std::cerr << "bytecode cache " << path << " is damaged" << std::endl;
+        return nullptr;
+    }
+    return code;
+}
+
+std::string MakeKey(std::string_view source, const char* filename,
+                    int flags) {
+    std::string_view version = JS_GetVersion();
+    std::string_view name = filename ? filename : "";
+
+    uint64_t hash = HashSeed;
+    hash = Hash(hash, version.data(), version.size());
+    hash = Hash(hash, &flags, sizeof(flags));
+    hash = Hash(hash, name.data(), name.size() + 1);
+    hash = Hash(hash, source.data(), source.size());
+
+    // source length makes collision even less likely
+    std::stringstream ss;
+    ss << std::hex << hash << "-" << source.size();
+    return ss.str();
+}
+
+}  // namespace
+
+BytecodeCache& BytecodeCache::Instance() {
+    static BytecodeCache cache;
+    return cache;
+}
+
+void BytecodeCache::SetDirectory(const std::string& dir) {
+    std::error_code err;
+    if (!dir.empty() && !std::filesystem::create_directories(dir, err) &&
+        err) {
+        std::cerr << "create bytecode cache dir " << dir
+                  << " failed: " << err.message() << std::endl;
+        return;
+    }
+
+    std::lock_guard lock{m_mutex};
+    m_dir = dir;
+}
+
+void BytecodeCache::SetCapacity(size_t bytes) {
+    std::lock_guard lock{m_mutex};
+    m_capacity = bytes;
+    Evict();
+}
+
+std::shared_ptr<const Bytecode> BytecodeCache::GetOrCompile(
+    JSContext* ctx, std::string_view source, const char* filename,
+    int flags) {
+    std::string key = MakeKey(source, filename, flags);
+    if (auto code = Find(key)) {
+        return code;
+    }
+
+    // JS_Eval need NUL terminated input
+    std::string input{source};
+    JSValue obj = JS_Eval(ctx, input.c_str(), input.size(), filename,
+                          flags | JS_EVAL_FLAG_COMPILE_ONLY);
+    if (JS_IsException(obj)) {
+        return nullptr;
+    }
+
+    size_t size;
+    uint8_t* buf = JS_WriteObject(ctx, &size, obj, JS_WRITE_OBJ_BYTECODE);
+    JS_FreeValue(ctx, obj);
+    if (!buf) {
+        return nullptr;
+    }
+    auto code = std::make_shared<const Bytecode>(buf, buf + size);
+    js_free(ctx, buf);
+
+    Store(key, code);
+    return code;
+}
+
+BytecodeCacheStats BytecodeCache::Stats() const {
+    std::lock_guard lock{m_mutex};
+    return m_stats;
+}
+
+std::shared_ptr<const Bytecode> BytecodeCache::Find(const std::string& key) {
+    std::string dir;
+    {
+        std::lock_guard lock{m_mutex};
+        if (auto it = m_entries.find(key); it != m_entries.end()) {
+            m_stats.memory_hits++;
+            m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+            return it->second.code;
+        }
+        dir = m_dir;
+    }
+
+    if (dir.empty()) {
+        return nullptr;
+    }
+
+    auto code = ReadCacheFile(dir + "/" + key + ".qjs");
+    if (!code || code->empty()) {
+        return nullptr;
+    }
+
+    std::lock_guard lock{m_mutex};
+    m_stats.disk_hits++;
+    return Insert(key, std::move(code));
+}
+
+void BytecodeCache::Store(const std::string& key,
+                          std::shared_ptr<const Bytecode> code) {
+    std::string dir;
+    {
+        std::lock_guard lock{m_mutex};
+        m_stats.compiles++;
+        Insert(key, code);
+        dir = m_dir;
+    }
+
+    if (dir.empty()) {
+        return;
+    }
+
+    // write to temporary file then rename, readers never see partial file
+    std::string path = dir + "/" + key + ".qjs";
+    std::string tmp_path =
+        path + "." + std::to_string(reinterpret_cast<uintptr_t>(code.get()));
+    {
+        std::ofstream file(tmp_path, std::ios::out | std::ios::binary);
+        FileHeader header = MakeHeader(*code);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(code->data()), code->size());
+        if (!file) {
+            std::cerr << "write bytecode cache " << path << " failed"
+                      << std::endl;
+            file.close();
+            std::error_code err;
+            std::filesystem::remove(tmp_path, err);
+            return;
+        }
+    }
+
+    std::error_code err;
+    std::filesystem::rename(tmp_path, path, err);
+    if (err) {
+        std::filesystem::remove(tmp_path, err);
+    }
+}
+
+std::shared_ptr<const Bytecode> BytecodeCache::Insert(
+    const std::string& key, std::shared_ptr<const Bytecode> code) {
+    if (auto it = m_entries.find(key); it != m_entries.end()) {
+        // another thread may load it meanwhile, keep the first one
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        return it->second.code;
+    }
+
+    m_lru.push_front(key);
+    m_stats.memory_bytes += code->size();
+    m_entries.emplace(key, Entry{code, m_lru.begin()});
+    Evict();
+    // still valid when evicted right away, caller keeps a reference
+    return code;
+}
+
+void BytecodeCache::Evict() {
+    while (m_stats.memory_bytes > m_capacity && !m_lru.empty()) {
+        auto it = m_entries.find(m_lru.back());
+        m_stats.memory_bytes -= it->second.code->size();
+        m_entries.erase(it);
+        m_lru.pop_back();
+        m_stats.evictions++;
+    }
+}
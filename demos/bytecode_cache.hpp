@@ -0,0 +1,80 @@
+#pragma once
+
+#include "quickjs.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using Bytecode = std::vector<uint8_t>;
+
+struct BytecodeCacheStats {
+    size_t memory_hits = 0;
+    size_t disk_hits = 0;
+    size_t compiles = 0;
+    size_t evictions = 0;
+    size_t memory_bytes = 0;  // bytecode held in memory
+};
+
+/* content-addressed cache of compiled scripts used by ExecuteScript.
+ *
+ * key is hash of (quickjs version, eval flags, filename, source), so an
+ * entry never need explicit invalidation: changed source or upgraded quickjs
+ * just lead to a new key. Bytecode is kept in memory (shared by all
+ * runtimes, least recently used entries are dropped over capacity) and
+ * optionally in a directory to skip parsing in later runs. Disk files start
+ * with a header (quickjs version, length & hash of bytecode), damaged or
+ * foreign files are ignored
+ */
+class BytecodeCache {
+public:
+    static BytecodeCache& Instance();
+
+    // enable on-disk cache, empty to disable (default)
+    void SetDirectory(const std::string& dir);
+
+    // bytes of bytecode kept in memory, evict old entries when shrinking
+    void SetCapacity(size_t bytes);
+
+    /* return bytecode of source, compile it by JS_EVAL_FLAG_COMPILE_ONLY
+     * when missing. nullptr when failed (exception is pending in ctx)
+     */
+    std::shared_ptr<const Bytecode> GetOrCompile(JSContext* ctx,
+                                                 std::string_view source,
+                                                 const char* filename,
+                                                 int flags);
+
+    BytecodeCacheStats Stats() const;
+
+    static constexpr size_t DefaultCapacity = 64 * 1024 * 1024;
+
+private:
+    struct Entry {
+        std::shared_ptr<const Bytecode> code;
+        // position in m_lru
+        std::list<std::string>::iterator lru;
+    };
+
+    std::unordered_map<std::string, Entry> m_entries;
+    // keys, most recently used first
+    std::list<std::string> m_lru;
+    size_t m_capacity = DefaultCapacity;
+    std::string m_dir;
+    BytecodeCacheStats m_stats;
+    mutable std::mutex m_mutex;
+
+    BytecodeCache() = default;
+
+    std::shared_ptr<const Bytecode> Find(const std::string& key);
+    void Store(const std::string& key, std::shared_ptr<const Bytecode> code);
+    // insert or touch key, hold m_mutex. Return the entry's bytecode
+    std::shared_ptr<const Bytecode> Insert(
+        const std::string& key, std::shared_ptr<const Bytecode> code);
+    // drop entries until under capacity, hold m_mutex
+    void Evict();
+};
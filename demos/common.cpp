@@ -1,4 +1,6 @@
 #include "common.hpp"
+#include "bytecode_cache.hpp"
+#include "mapped_file.hpp"
 #include <fstream>
 #include <sstream>
 
@@ -11,9 +13,34 @@ void ExecuteScript(JSContext* ctx, const std::string& filename, int flags) {
     ss << file.rdbuf();
     std::string content = ss.str();
 
-    JSValue result =
-        JS_Eval(ctx, content.c_str(), content.size(), nullptr, flags);
+    // only parse & compile when this source is never seen
+    auto code =
+        BytecodeCache::Instance().GetOrCompile(ctx, content, nullptr, flags);
+    if (!code) {
+        js_std_dump_error(ctx);
+        return;
+    }
+
+    ExecuteBytecode(ctx, code->data(), code->size());
+}
 
+void ExecuteBytecode(JSContext* ctx, const uint8_t* data, size_t size) {
+    JSValue obj = JS_ReadObject(ctx, data, size, JS_READ_OBJ_BYTECODE);
+    if (JS_IsException(obj)) {
+        js_std_dump_error(ctx);
+        return;
+    }
+
+    // module need resolve imports before evaluation
+    if (JS_VALUE_GET_TAG(obj) == JS_TAG_MODULE &&
+        JS_ResolveModule(ctx, obj) < 0) {
+        JS_FreeValue(ctx, obj);
+        js_std_dump_error(ctx);
+        return;
+    }
+
+    // JS_EvalFunction takes the ownership of obj
+    JSValue result = JS_EvalFunction(ctx, obj);
     if (JS_IsException(result)) {
         js_std_dump_error(ctx);
     }
@@ -21,6 +48,17 @@ void ExecuteScript(JSContext* ctx, const std::string& filename, int flags) {
     JS_FreeValue(ctx, result);
 }
 
+void ExecuteBinaryScript(JSContext* ctx, const std::string& filename) {
+    // error is reported by MappedFile::Open
+    auto file = MappedFile::Open(filename);
+    if (!file) {
+        return;
+    }
+
+    // mapping is kept by `file` until evaluation finished
+    ExecuteBytecode(ctx, file->Data(), file->Size());
+}
+
 void CheckJSValue(JSContext* ctx, JSValue value) {
     if (JS_IsException(value)) {
         js_std_dump_error(ctx);
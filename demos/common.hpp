@@ -14,6 +14,15 @@
         }                                                                  \
     } while (0)
 
+/* source is compiled once & cached by content (see bytecode_cache.hpp), call
+ * BytecodeCache::Instance().SetDirectory() to also keep it between runs
+ */
 void ExecuteScript(JSContext* ctx, const std::string& filename, int flags);
 
+// run bytecode generated by `qjsc -b` or JS_WriteObject
+void ExecuteBytecode(JSContext* ctx, const uint8_t* data, size_t size);
+
+// load .qjs file by memory mapping (see mapped_file.hpp), no copy
+void ExecuteBinaryScript(JSContext* ctx, const std::string& filename);
+
 void CheckJSValue(JSContext* ctx, JSValueConst value);
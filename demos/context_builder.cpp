@@ -0,0 +1,171 @@
+#include "context_builder.hpp"
+#include <iterator>
+
+namespace {
+
+constexpr int MaxGlobals = 16;
+
+struct IntrinsicInfo {
+    Intrinsic intrinsic;
+    void (*add)(JSContext*);
+    // globals defined by add, nullptr terminated. Empty: can't be lazy
+    const char* globals[MaxGlobals + 1];
+};
+
+// in the order of JS_NewContext
+const IntrinsicInfo gIntrinsics[] = {
+    {Intrinsic::BaseObjects, JS_AddIntrinsicBaseObjects, {}},
+    {Intrinsic::Date, JS_AddIntrinsicDate, {"Date"}},
+    {Intrinsic::Eval, JS_AddIntrinsicEval, {}},
+    {Intrinsic::RegExpCompiler, JS_AddIntrinsicRegExpCompiler, {}},
+    {Intrinsic::RegExp, JS_AddIntrinsicRegExp, {}},
+    {Intrinsic::JSON, JS_AddIntrinsicJSON, {"JSON"}},
+    {Intrinsic::Proxy, JS_AddIntrinsicProxy, {"Proxy"}},
+    {Intrinsic::MapSet,
+     JS_AddIntrinsicMapSet,
+     {"Map", "Set", "WeakMap", "WeakSet"}},
+    {Intrinsic::TypedArrays,
+     JS_AddIntrinsicTypedArrays,
+     {"ArrayBuffer", "SharedArrayBuffer", "Uint8ClampedArray", "Int8Array",
+      "Uint8Array", "Int16Array", "Uint16Array", "Int32Array", "Uint32Array",
+      "BigInt64Array", "BigUint64Array", "Float16Array", "Float32Array",
+      "Float64Array", "DataView", "Atomics"}},
+    {Intrinsic::Promise, JS_AddIntrinsicPromise, {}},
+    {Intrinsic::BigInt, JS_AddIntrinsicBigInt, {}},
+    {Intrinsic::WeakRef,
+     JS_AddIntrinsicWeakRef,
+     {"WeakRef", "FinalizationRegistry"}},
+};
+
+bool CanBeLazy(const IntrinsicInfo& info) {
+    return info.globals[0] != nullptr;
+}
+
+// magic of lazy accessor: which intrinsic & which of its globals
+int EncodeMagic(int intrinsic_index, int global_index) {
+    return intrinsic_index * MaxGlobals + global_index;
+}
+
+/* remove lazy accessors of intrinsic & install it, state (shared by all
+ * accessors of the intrinsic) remember it is done, so an accessor kept by
+ * script doesn't install twice
+ */
+bool InstallLazy(JSContext* ctx, const IntrinsicInfo& info,
+                 JSValueConst state) {
+    JSValue installed = JS_GetPropertyStr(ctx, state, "installed");
+    if (JS_IsException(installed)) {
+        return false;
+    }
+    if (!JS_IsUndefined(installed)) {
+        return true;
+    }
+    if (JS_SetPropertyStr(ctx, state, "installed", JS_TRUE) < 0) {
+        return false;
+    }
+
+    JSValue global_this = JS_GetGlobalObject(ctx);
+    for (const char* const* name = info.globals; *name; name++) {
+        JSAtom atom = JS_NewAtom(ctx, *name);
+        JS_DeleteProperty(ctx, global_this, atom, 0);
+        JS_FreeAtom(ctx, atom);
+    }
+    JS_FreeValue(ctx, global_this);
+
+    info.add(ctx);
+    return true;
+}
+
+// getter (argc == 0) & setter (argc == 1) of a lazy global
+JSValue LazyAccessor(JSContext* ctx, JSValueConst, int argc,
+                     JSValueConst* argv, int magic, JSValueConst* data) {
+    const IntrinsicInfo& info = gIntrinsics[magic / MaxGlobals];
+    const char* name = info.globals[magic % MaxGlobals];
+    if (!InstallLazy(ctx, info, data[0])) {
+        return JS_EXCEPTION;
+    }
+
+    // now the real global is there
+    JSValue global_this = JS_GetGlobalObject(ctx);
+    JSValue result;
+    if (argc == 0) {
+        result = JS_GetPropertyStr(ctx, global_this, name);
+    } else {
+        JSValue value = JS_DupValue(ctx, argv[0]);
+        bool success = JS_SetPropertyStr(ctx, global_this, name, value) >= 0;
+        result = success ? JS_UNDEFINED : JS_EXCEPTION;
+    }
+    JS_FreeValue(ctx, global_this);
+    return result;
+}
+
+bool DefineLazy(JSContext* ctx, int intrinsic_index) {
+    const IntrinsicInfo& info = gIntrinsics[intrinsic_index];
+
+    JSValue state = JS_NewObject(ctx);
+    if (JS_IsException(state)) {
+        return false;
+    }
+
+    JSValue global_this = JS_GetGlobalObject(ctx);
+    bool success = true;
+    for (int i = 0; success && info.globals[i]; i++) {
+        int magic = EncodeMagic(intrinsic_index, i);
+        JSValue getter =
+            JS_NewCFunctionData(ctx, LazyAccessor, 0, magic, 1, &state);
+        JSValue setter =
+            JS_NewCFunctionData(ctx, LazyAccessor, 1, magic, 1, &state);
+        JSAtom atom = JS_NewAtom(ctx, info.globals[i]);
+        // configurable, so it can be replaced by the real one
+        success = !JS_IsException(getter) && !JS_IsException(setter) &&
+                  JS_DefineProperty(ctx, global_this, atom, JS_UNDEFINED,
+                                    getter, setter,
+                                    JS_PROP_HAS_GET | JS_PROP_HAS_SET |
+                                        JS_PROP_HAS_CONFIGURABLE |
+                                        JS_PROP_CONFIGURABLE) >= 0;
+        JS_FreeAtom(ctx, atom);
+        JS_FreeValue(ctx, getter);
+        JS_FreeValue(ctx, setter);
+    }
+    JS_FreeValue(ctx, global_this);
+    JS_FreeValue(ctx, state);
+    return success;
+}
+
+}  // namespace
+
+ContextBuilder& ContextBuilder::Add(Intrinsic intrinsics) {
+    m_eager |= static_cast<uint32_t>(intrinsics);
+    return *this;
+}
+
+ContextBuilder& ContextBuilder::Lazy(Intrinsic intrinsics) {
+    m_lazy |= static_cast<uint32_t>(intrinsics);
+    return *this;
+}
+
+JSContext* ContextBuilder::Build(JSRuntime* runtime) const {
+    JSContext* ctx = JS_NewContextRaw(runtime);
+    if (!ctx) {
+        return nullptr;
+    }
+
+    uint32_t eager = m_eager | static_cast<uint32_t>(Intrinsic::BaseObjects);
+    for (const IntrinsicInfo& info : gIntrinsics) {
+        uint32_t bit = static_cast<uint32_t>(info.intrinsic);
+        // intrinsics used by syntax can't wait for a global access
+        if ((eager & bit) || ((m_lazy & bit) && !CanBeLazy(info))) {
+            info.add(ctx);
+        }
+    }
+
+    for (int i = 0; i < static_cast<int>(std::size(gIntrinsics)); i++) {
+        const IntrinsicInfo& info = gIntrinsics[i];
+        uint32_t bit = static_cast<uint32_t>(info.intrinsic);
+        if ((m_lazy & bit) && !(eager & bit) && CanBeLazy(info) &&
+            !DefineLazy(ctx, i)) {
+            JS_FreeContext(ctx);
+            return nullptr;
+        }
+    }
+    return ctx;
+}
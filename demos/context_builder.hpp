@@ -0,0 +1,62 @@
+#pragma once
+
+#include "quickjs.h"
+#include <cstdint>
+
+/* create context by JS_NewContextRaw with only the intrinsics script need,
+ * JS_NewContext install all of them (Date, RegExp, Proxy, Promise...):
+ *
+ *   JSContext* ctx = ContextBuilder{}
+ *                        .Add(Intrinsic::JSON)
+ *                        .Lazy(Intrinsic::Date | Intrinsic::MapSet)
+ *                        .Build(runtime);
+ *
+ * lazy intrinsics are installed the first time script reads/writes one of
+ * their globals (e.g. `Date`). Only Date, JSON, Proxy, MapSet, TypedArrays
+ * and WeakRef can be lazy, others are used by syntax (regexp literal,
+ * async function ...) rather than globals, so Lazy() add them eagerly.
+ * Native code creating TypedArray/Promise... itself (typed_array.hpp) must
+ * Add() them
+ */
+
+enum class Intrinsic : uint32_t {
+    None = 0,
+    BaseObjects = 1 << 0,  // Object, Function, Array, Error..., always added
+    Date = 1 << 1,
+    Eval = 1 << 2,  // needed by JS_Eval (not by bytecode)
+    RegExpCompiler = 1 << 3,
+    RegExp = 1 << 4,  // need RegExpCompiler to compile patterns
+    JSON = 1 << 5,
+    Proxy = 1 << 6,
+    MapSet = 1 << 7,
+    TypedArrays = 1 << 8,
+    Promise = 1 << 9,  // needed by async function & module evaluation
+    BigInt = 1 << 10,
+    WeakRef = 1 << 11,
+    All = (1 << 12) - 1,
+};
+
+constexpr Intrinsic operator|(Intrinsic a, Intrinsic b) {
+    return static_cast<Intrinsic>(static_cast<uint32_t>(a) |
+                                  static_cast<uint32_t>(b));
+}
+
+class ContextBuilder {
+public:
+    // BaseObjects & Eval by default
+    ContextBuilder() = default;
+
+    // installed when context is created
+    ContextBuilder& Add(Intrinsic intrinsics);
+
+    // installed on first access of its globals
+    ContextBuilder& Lazy(Intrinsic intrinsics);
+
+    // nullptr when failed
+    JSContext* Build(JSRuntime* runtime) const;
+
+private:
+    uint32_t m_eager = static_cast<uint32_t>(Intrinsic::BaseObjects) |
+                       static_cast<uint32_t>(Intrinsic::Eval);
+    uint32_t m_lazy = 0;
+};
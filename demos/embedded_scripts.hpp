@@ -0,0 +1,29 @@
+#pragma once
+
+#include "common.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/* scripts precompiled & embedded into executable by EmbedScripts() in
+ * demos/CMakeLists.txt, no file I/O nor parsing when loading them
+ */
+
+struct EmbeddedScript {
+    std::string_view name;  // script file name, e.g. "main.js"
+    const uint8_t* data;    // bytecode
+    size_t size;
+};
+
+// defined in the source generated for target, nullptr when not found
+const EmbeddedScript* FindEmbeddedScript(std::string_view name);
+
+// like ExecuteScript, but run embedded bytecode
+inline void ExecuteEmbeddedScript(JSContext* ctx, std::string_view name) {
+    const EmbeddedScript* script = FindEmbeddedScript(name);
+    if (!script) {
+        std::cerr << "embedded script " << name << " not found" << std::endl;
+        return;
+    }
+    ExecuteBytecode(ctx, script->data, script->size);
+}
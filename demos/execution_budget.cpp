@@ -0,0 +1,138 @@
+#include "execution_budget.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace {
+
+uint64_t ThreadCpuTimeNs() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel,
+                        &user)) {
+        return 0;
+    }
+    auto to_ns = [](const FILETIME& time) {
+        // 100ns unit
+        return ((static_cast<uint64_t>(time.dwHighDateTime) << 32) |
+                time.dwLowDateTime) *
+               100;
+    };
+    return to_ns(kernel) + to_ns(user);
+#else
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+}  // namespace
+
+const char* ToString(BudgetStatus status) {
+    switch (status) {
+        case BudgetStatus::Ok:
+            return "ok";
+        case BudgetStatus::CpuTimeExceeded:
+            return "cpu time budget exceeded";
+        case BudgetStatus::InstructionsExceeded:
+            return "instruction budget exceeded";
+        case BudgetStatus::Interrupted:
+            return "interrupted";
+    }
+    return "unknown";
+}
+
+ExecutionBudget::ExecutionBudget(JSRuntime* runtime) : m_runtime{runtime} {
+    // once, runtime is usually still small here
+    JSMemoryUsage usage;
+    JS_ComputeMemoryUsage(runtime, &usage);
+    m_base_memory_limit =
+        usage.malloc_limit > 0 ? static_cast<size_t>(usage.malloc_limit) : 0;
+    InstallHandler();
+}
+
+ExecutionBudget::~ExecutionBudget() {
+    Disarm();
+    JS_SetInterruptHandler(m_runtime, nullptr, nullptr);
+}
+
+void ExecutionBudget::SetBaseLimits(size_t memory_limit,
+                                    size_t max_stack_size) {
+    m_base_memory_limit = memory_limit;
+    m_base_stack_size = max_stack_size ? max_stack_size : DefaultMaxStackSize;
+    if (!m_armed) {
+        JS_SetMemoryLimit(m_runtime, m_base_memory_limit);
+        JS_SetMaxStackSize(m_runtime, m_base_stack_size);
+    }
+}
+
+void ExecutionBudget::Arm(const ExecutionLimits& limits) {
+    m_limits = limits;
+    m_polls = 0;
+    m_status = BudgetStatus::Ok;
+    m_interrupt_requested.store(false, std::memory_order_relaxed);
+    m_cpu_deadline_ns =
+        limits.cpu_time.count() > 0
+            ? ThreadCpuTimeNs() +
+                  static_cast<uint64_t>(limits.cpu_time.count()) * 1000
+            : 0;
+
+    size_t memory_limit = m_base_memory_limit;
+    if (limits.memory_limit && (!memory_limit ||
+                                limits.memory_limit < memory_limit)) {
+        memory_limit = limits.memory_limit;
+    }
+    JS_SetMemoryLimit(m_runtime, memory_limit);
+    // stack limit is relative to current stack top, thread may changed
+    JS_UpdateStackTop(m_runtime);
+    JS_SetMaxStackSize(m_runtime, limits.max_stack_size ? limits.max_stack_size
+                                                        : m_base_stack_size);
+    m_armed = true;
+}
+
+void ExecutionBudget::Disarm() {
+    if (!m_armed) {
+        return;
+    }
+    m_armed = false;
+    JS_SetMemoryLimit(m_runtime, m_base_memory_limit);
+    JS_SetMaxStackSize(m_runtime, m_base_stack_size);
+}
+
+void ExecutionBudget::Interrupt() {
+    m_interrupt_requested.store(true, std::memory_order_relaxed);
+}
+
+void ExecutionBudget::InstallHandler() {
+    JS_SetInterruptHandler(m_runtime, InterruptHandler, this);
+}
+
+bool ExecutionBudget::Poll() {
+    if (m_interrupt_requested.load(std::memory_order_relaxed)) {
+        m_status = BudgetStatus::Interrupted;
+        return true;
+    }
+    if (!m_armed) {
+        return false;
+    }
+
+    m_polls++;
+    if (m_limits.instructions &&
+        m_polls * InstructionsPerPoll > m_limits.instructions) {
+        m_status = BudgetStatus::InstructionsExceeded;
+        return true;
+    }
+    if (m_cpu_deadline_ns && ThreadCpuTimeNs() > m_cpu_deadline_ns) {
+        m_status = BudgetStatus::CpuTimeExceeded;
+        return true;
+    }
+    return false;
+}
+
+int ExecutionBudget::InterruptHandler(JSRuntime*, void* opaque) {
+    return static_cast<ExecutionBudget*>(opaque)->Poll() ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "quickjs.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/* bound one execution (eval + pending jobs) of a runtime, so a runaway
+ * script is stopped instead of stalling its thread:
+ *
+ *   ExecutionBudget budget{runtime};  // install interrupt handler
+ *   {
+ *       ScopedBudget scoped{budget, limits};
+ *       ExecuteScript(ctx, "main.js", JS_EVAL_TYPE_GLOBAL);
+ *       js_std_loop(ctx);
+ *   }
+ *   if (budget.Status() != BudgetStatus::Ok) ...
+ *
+ * exhausted budget make quickjs throw an uncatchable "interrupted" error,
+ * the script unwinds normally so the runtime can run the next one.
+ * Memory/stack limits make allocation/recursion throw (catchable) errors,
+ * Disarm() puts the runtime's own limits back (see SetBaseLimits)
+ */
+
+struct ExecutionLimits {
+    // CPU time of the executing thread, 0 means no limit
+    std::chrono::microseconds cpu_time{0};
+    /* approximate instruction count, 0 means no limit. quickjs poll the
+     * interrupt handler about every InstructionsPerPoll branches/calls, so
+     * it is counted in that granularity
+     */
+    uint64_t instructions = 0;
+    /* JS_SetMemoryLimit of the whole runtime, 0 keeps the runtime's own
+     * limit. Never raised above the runtime's own limit
+     */
+    size_t memory_limit = 0;
+    // JS_SetMaxStackSize, 0 keeps the runtime's own size
+    size_t max_stack_size = 0;
+};
+
+enum class BudgetStatus {
+    Ok,
+    CpuTimeExceeded,
+    InstructionsExceeded,
+    Interrupted,  // by Interrupt()
+};
+
+const char* ToString(BudgetStatus status);
+
+class ExecutionBudget {
+public:
+    // JS_INTERRUPT_COUNTER_INIT of quickjs
+    static constexpr uint64_t InstructionsPerPoll = 10000;
+    // JS_DEFAULT_STACK_SIZE of quickjs
+    static constexpr size_t DefaultMaxStackSize = 1024 * 1024;
+
+    // budget own the interrupt handler & limits of runtime
+    explicit ExecutionBudget(JSRuntime* runtime);
+    ExecutionBudget(const ExecutionBudget&) = delete;
+    ExecutionBudget& operator=(const ExecutionBudget&) = delete;
+    ~ExecutionBudget();
+
+    /* limits of the runtime outside of Arm/Disarm. Memory limit is read
+     * when the budget is constructed, stack size is assumed to be quickjs
+     * default (quickjs has no getter). Change them here instead of
+     * JS_SetMemoryLimit/JS_SetMaxStackSize, or Disarm() overwrites them
+     */
+    void SetBaseLimits(size_t memory_limit, size_t max_stack_size);
+
+    // start counting, call in the thread which will run script
+    void Arm(const ExecutionLimits& limits);
+    // restore base limits, keep Status() until next Arm()
+    void Disarm();
+
+    // preempt running script, thread-safe
+    void Interrupt();
+
+    /* check limits, true: stop the script. For an interrupt handler which
+     * replaces the budget's one & forwards to it (see SamplingProfiler)
+     */
+    bool Poll();
+    // install budget's interrupt handler again after it was replaced
+    void InstallHandler();
+
+    BudgetStatus Status() const { return m_status; }
+
+private:
+    JSRuntime* m_runtime;
+    bool m_armed = false;
+    ExecutionLimits m_limits;
+    size_t m_base_memory_limit = 0;
+    size_t m_base_stack_size = DefaultMaxStackSize;
+    uint64_t m_cpu_deadline_ns = 0;
+    uint64_t m_polls = 0;
+    BudgetStatus m_status = BudgetStatus::Ok;
+    std::atomic<bool> m_interrupt_requested{false};
+
+    static int InterruptHandler(JSRuntime* runtime, void* opaque);
+};
+
+class ScopedBudget {
+public:
+    ScopedBudget(ExecutionBudget& budget, const ExecutionLimits& limits)
+        : m_budget{budget} {
+        m_budget.Arm(limits);
+    }
+
+    ScopedBudget(const ScopedBudget&) = delete;
+    ScopedBudget& operator=(const ScopedBudget&) = delete;
+
+    ~ScopedBudget() { m_budget.Disarm(); }
+
+private:
+    ExecutionBudget& m_budget;
+};
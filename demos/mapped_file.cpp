@@ -0,0 +1,110 @@
+#include "mapped_file.hpp"
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::shared_ptr<const MappedFile> MappedFile::Open(
+    const std::string& filename) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::weak_ptr<const MappedFile>>
+        mappings;
+
+    std::lock_guard lock{mutex};
+    if (auto mapping = mappings[filename].lock()) {
+        return mapping;
+    }
+
+    std::shared_ptr<MappedFile> mapping{new MappedFile};
+    if (!mapping->Map(filename)) {
+        std::cerr << "map file " << filename << " failed" << std::endl;
+        mappings.erase(filename);
+        return nullptr;
+    }
+    mappings[filename] = mapping;
+    return mapping;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Map(const std::string& filename) {
+    m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                         nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                         nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        m_file = nullptr;
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+        return false;
+    }
+
+    m_mapping =
+        CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping) {
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*>(
+        MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    m_size = static_cast<size_t>(size.QuadPart);
+    return m_data != nullptr;
+}
+
+MappedFile::~MappedFile() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+    }
+    if (m_file) {
+        CloseHandle(m_file);
+    }
+}
+
+#else
+
+bool MappedFile::Map(const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    // mmap can't map an empty file
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // mapping keeps the file alive
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*>(data);
+    m_size = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+MappedFile::~MappedFile() {
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+}
+
+#endif
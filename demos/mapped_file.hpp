@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/* read-only memory mapping of a file (e.g. precompiled .qjs bytecode).
+ *
+ * Open() shares one mapping per path inside the process, so all runtimes
+ * (and workers) read the same physical pages without copying the file
+ */
+class MappedFile {
+public:
+    // nullptr when failed. NOTE: don't rewrite a file while it is mapped
+    static std::shared_ptr<const MappedFile> Open(const std::string& filename);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const uint8_t* Data() const { return m_data; }
+
+    size_t Size() const { return m_size; }
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+
+    MappedFile() = default;
+    bool Map(const std::string& filename);
+};
@@ -0,0 +1,256 @@
+#include "memory_telemetry.hpp"
+#include <cstdio>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace {
+
+std::mutex gClassCounterMutex;
+// never freed, binders keep pointers to them
+std::vector<std::unique_ptr<NativeClassCounter>> gClassCounters;
+
+struct UsageMetric {
+    const char* name;
+    const char* help;
+    int64_t JSMemoryUsage::*field;
+};
+
+// from the arena when there is one, otherwise from the heap walk
+const UsageMetric gMallocMetric = {"qjs_runtime_malloc_bytes",
+                                   "Bytes allocated by the runtime",
+                                   &JSMemoryUsage::malloc_size};
+
+// only known after a heap walk
+const UsageMetric gUsageMetrics[] = {
+    {"qjs_runtime_malloc_limit_bytes", "Memory limit of the runtime",
+     &JSMemoryUsage::malloc_limit},
+    {"qjs_runtime_memory_used_bytes", "Bytes used by quickjs objects",
+     &JSMemoryUsage::memory_used_size},
+    {"qjs_runtime_malloc_count", "Live allocations of the runtime",
+     &JSMemoryUsage::malloc_count},
+    {"qjs_runtime_objects", "Live JS objects", &JSMemoryUsage::obj_count},
+    {"qjs_runtime_object_bytes", "Bytes of JS objects",
+     &JSMemoryUsage::obj_size},
+    {"qjs_runtime_property_bytes", "Bytes of object properties",
+     &JSMemoryUsage::prop_size},
+    {"qjs_runtime_shape_bytes", "Bytes of object shapes",
+     &JSMemoryUsage::shape_size},
+    {"qjs_runtime_strings", "Live strings", &JSMemoryUsage::str_count},
+    {"qjs_runtime_string_bytes", "Bytes of strings",
+     &JSMemoryUsage::str_size},
+    {"qjs_runtime_atoms", "Interned atoms", &JSMemoryUsage::atom_count},
+    {"qjs_runtime_atom_bytes", "Bytes of atoms", &JSMemoryUsage::atom_size},
+    {"qjs_runtime_functions", "Bytecode functions",
+     &JSMemoryUsage::js_func_count},
+    {"qjs_runtime_function_bytes", "Bytes of bytecode functions",
+     &JSMemoryUsage::js_func_size},
+    {"qjs_runtime_function_code_bytes", "Bytes of bytecode",
+     &JSMemoryUsage::js_func_code_size},
+    {"qjs_runtime_binary_object_bytes",
+     "Bytes of ArrayBuffers & typed arrays",
+     &JSMemoryUsage::binary_object_size},
+};
+
+struct ArenaMetric {
+    const char* name;
+    const char* help;
+    const char* type;
+    size_t ArenaStats::*field;
+};
+
+const ArenaMetric gArenaMetrics[] = {
+    {"qjs_runtime_reserved_bytes", "Bytes the arena took from the system",
+     "gauge", &ArenaStats::reserved_bytes},
+    {"qjs_runtime_peak_malloc_bytes", "Most bytes allocated at once",
+     "gauge", &ArenaStats::peak_used_bytes},
+    {"qjs_runtime_failed_allocations_total",
+     "Allocations rejected by the memory limit or the system", "counter",
+     &ArenaStats::failed_count},
+};
+
+void WriteHeader(std::ostream& out, const char* name, const char* help,
+                 const char* type) {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+}
+
+// label value escaping of the text format
+void WriteLabel(std::ostream& out, const std::string& value) {
+    for (char ch : value) {
+        if (ch == '\\' || ch == '"') {
+            out << '\\' << ch;
+        } else if (ch == '\n') {
+            out << "\\n";
+        } else {
+            out << ch;
+        }
+    }
+}
+
+}  // namespace
+
+NativeClassCounter& NativeClassCounter::Get(const std::string& class_name,
+                                            size_t object_size) {
+    std::lock_guard lock{gClassCounterMutex};
+    for (auto& counter : gClassCounters) {
+        if (counter->ClassName() == class_name) {
+            return *counter;
+        }
+    }
+    return *gClassCounters.emplace_back(
+        std::make_unique<NativeClassCounter>(class_name, object_size));
+}
+
+MemoryTelemetry::RuntimeEntry& MemoryTelemetry::GetEntry(
+    JSRuntime* runtime) {
+    auto [it, inserted] = m_runtimes.try_emplace(runtime);
+    if (inserted) {
+        // not added by AddRuntime, name it by address
+        char name[32];
+        snprintf(name, sizeof(name), "%p", static_cast<void*>(runtime));
+        it->second.name = name;
+    }
+    return it->second;
+}
+
+const RuntimeArena* MemoryTelemetry::FindArena(JSRuntime* runtime) const {
+    std::lock_guard lock{m_mutex};
+    auto it = m_runtimes.find(runtime);
+    return it != m_runtimes.end() ? it->second.arena : nullptr;
+}
+
+void MemoryTelemetry::AddRuntime(JSRuntime* runtime, std::string name,
+                                 const RuntimeArena* arena) {
+    std::lock_guard lock{m_mutex};
+    RuntimeEntry& entry = GetEntry(runtime);
+    entry.name = std::move(name);
+    entry.arena = arena;
+}
+
+void MemoryTelemetry::RemoveRuntime(JSRuntime* runtime) {
+    std::lock_guard lock{m_mutex};
+    m_runtimes.erase(runtime);
+}
+
+void MemoryTelemetry::Sample(JSRuntime* runtime) {
+    const RuntimeArena* arena = FindArena(runtime);
+    if (!arena) {
+        SampleHeap(runtime);
+        return;
+    }
+
+    // the arena is only written by this thread
+    std::lock_guard lock{m_mutex};
+    RuntimeEntry& entry = GetEntry(runtime);
+    entry.arena_stats = arena->Stats();
+    entry.usage.malloc_size =
+        static_cast<int64_t>(entry.arena_stats.used_bytes);
+    entry.sampled = true;
+}
+
+void MemoryTelemetry::SampleHeap(JSRuntime* runtime) {
+    // walk the heap outside of the lock
+    JSMemoryUsage usage;
+    JS_ComputeMemoryUsage(runtime, &usage);
+
+    std::lock_guard lock{m_mutex};
+    RuntimeEntry& entry = GetEntry(runtime);
+    entry.usage = usage;
+    if (entry.arena) {
+        // exact & consistent with Sample
+        entry.usage.malloc_size =
+            static_cast<int64_t>(entry.arena->Stats().used_bytes);
+    }
+    entry.heap_sampled = true;
+}
+
+int64_t MemoryTelemetry::AllocatedBytes(JSRuntime* runtime) {
+    if (const RuntimeArena* arena = FindArena(runtime)) {
+        return static_cast<int64_t>(arena->Stats().used_bytes);
+    }
+    JSMemoryUsage usage;
+    JS_ComputeMemoryUsage(runtime, &usage);
+    return usage.malloc_size;
+}
+
+void MemoryTelemetry::RecordModule(JSRuntime* runtime,
+                                   const std::string& module_name,
+                                   int64_t bytes) {
+    std::lock_guard lock{m_mutex};
+    GetEntry(runtime).modules[module_name] += bytes;
+}
+
+void MemoryTelemetry::WritePrometheus(std::ostream& out) const {
+    {
+        std::lock_guard lock{m_mutex};
+        WriteHeader(out, gMallocMetric.name, gMallocMetric.help, "gauge");
+        for (const auto& [runtime, entry] : m_runtimes) {
+            if (!entry.sampled && !entry.heap_sampled) {
+                continue;
+            }
+            out << gMallocMetric.name << "{runtime=\"";
+            WriteLabel(out, entry.name);
+            out << "\"} " << entry.usage.*gMallocMetric.field << "\n";
+        }
+
+        for (const ArenaMetric& metric : gArenaMetrics) {
+            WriteHeader(out, metric.name, metric.help, metric.type);
+            for (const auto& [runtime, entry] : m_runtimes) {
+                if (!entry.sampled) {
+                    continue;
+                }
+                out << metric.name << "{runtime=\"";
+                WriteLabel(out, entry.name);
+                out << "\"} " << entry.arena_stats.*metric.field << "\n";
+            }
+        }
+
+        for (const UsageMetric& metric : gUsageMetrics) {
+            WriteHeader(out, metric.name, metric.help, "gauge");
+            for (const auto& [runtime, entry] : m_runtimes) {
+                if (!entry.heap_sampled) {
+                    continue;
+                }
+                out << metric.name << "{runtime=\"";
+                WriteLabel(out, entry.name);
+                out << "\"} " << entry.usage.*metric.field << "\n";
+            }
+        }
+
+        WriteHeader(out, "qjs_module_load_bytes",
+                    "Bytes allocated by loading the module", "gauge");
+        for (const auto& [runtime, entry] : m_runtimes) {
+            for (const auto& [module_name, bytes] : entry.modules) {
+                out << "qjs_module_load_bytes{runtime=\"";
+                WriteLabel(out, entry.name);
+                out << "\",module=\"";
+                WriteLabel(out, module_name);
+                out << "\"} " << bytes << "\n";
+            }
+        }
+    }
+
+    std::lock_guard lock{gClassCounterMutex};
+    WriteHeader(out, "qjs_class_live_objects", "Live native objects of class",
+                "gauge");
+    for (const auto& counter : gClassCounters) {
+        out << "qjs_class_live_objects{class=\"";
+        WriteLabel(out, counter->ClassName());
+        out << "\"} " << counter->LiveCount() << "\n";
+    }
+    WriteHeader(out, "qjs_class_native_bytes",
+                "Bytes of live native objects of class", "gauge");
+    for (const auto& counter : gClassCounters) {
+        out << "qjs_class_native_bytes{class=\"";
+        WriteLabel(out, counter->ClassName());
+        out << "\"} " << counter->NativeBytes() << "\n";
+    }
+    WriteHeader(out, "qjs_class_created_total",
+                "Native objects of class created", "counter");
+    for (const auto& counter : gClassCounters) {
+        out << "qjs_class_created_total{class=\"";
+        WriteLabel(out, counter->ClassName());
+        out << "\"} " << counter->CreatedCount() << "\n";
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "arena_allocator.hpp"
+#include "quickjs.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+/* memory numbers for capacity planning, exported as Prometheus text:
+ *
+ *   - bytes allocated by every runtime (counted by its RuntimeArena) and
+ *     the heap breakdown of JS_ComputeMemoryUsage
+ *   - live objects & native bytes of every bound class (NativeClassCounter,
+ *     counted by ClassBinder automatically)
+ *   - memory taken by loading each module (ModuleRegistry::TrackMemory)
+ *
+ *   RuntimeArena arena;
+ *   JSRuntime* runtime = NewRuntimeWithAllocator(arena);
+ *   MemoryTelemetry telemetry;
+ *   telemetry.AddRuntime(runtime, "worker0", &arena);
+ *   telemetry.Sample(runtime);       // every second, in runtime's thread
+ *   telemetry.SampleHeap(runtime);   // now and then, walks the heap
+ *   telemetry.WritePrometheus(out);  // any thread, e.g. HTTP handler
+ *
+ * Sample only copies the counters of the arena. A runtime added without
+ * its arena has no counters, Sample walks its heap instead. Both run in
+ * the thread owning the runtime, export only reads the last samples &
+ * atomic counters
+ */
+
+/* live instances & native bytes of one class, process wide (class ids are
+ * shared by runtimes). Native bytes only cover the object itself, not heap
+ * memory it owns
+ */
+class NativeClassCounter {
+public:
+    // counter of class_name, created on first call & never freed
+    static NativeClassCounter& Get(const std::string& class_name,
+                                   size_t object_size);
+
+    NativeClassCounter(std::string class_name, size_t object_size)
+        : m_class_name{std::move(class_name)}, m_object_size{object_size} {}
+    NativeClassCounter(const NativeClassCounter&) = delete;
+    NativeClassCounter& operator=(const NativeClassCounter&) = delete;
+
+    // an object is created/destroyed (from constructor/finalizer)
+    void Add() {
+        m_live.fetch_add(1, std::memory_order_relaxed);
+        m_created.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Remove() { m_live.fetch_sub(1, std::memory_order_relaxed); }
+
+    const std::string& ClassName() const { return m_class_name; }
+
+    int64_t LiveCount() const {
+        return m_live.load(std::memory_order_relaxed);
+    }
+
+    int64_t CreatedCount() const {
+        return m_created.load(std::memory_order_relaxed);
+    }
+
+    int64_t NativeBytes() const {
+        return LiveCount() * static_cast<int64_t>(m_object_size);
+    }
+
+private:
+    std::string m_class_name;
+    size_t m_object_size;
+    std::atomic<int64_t> m_live{0};
+    std::atomic<int64_t> m_created{0};
+};
+
+class MemoryTelemetry {
+public:
+    /* label runtime in the export, call before Sample. arena is the one
+     * runtime was created with (NewRuntimeWithAllocator), must outlive
+     * RemoveRuntime
+     */
+    void AddRuntime(JSRuntime* runtime, std::string name,
+                    const RuntimeArena* arena = nullptr);
+    // drop its numbers, call before JS_FreeRuntime
+    void RemoveRuntime(JSRuntime* runtime);
+
+    // take allocated bytes of runtime, in the thread owning it
+    void Sample(JSRuntime* runtime);
+    // take the whole JS_ComputeMemoryUsage, costs a walk of the heap
+    void SampleHeap(JSRuntime* runtime);
+
+    /* bytes allocated by runtime now, in the thread owning it. Read from
+     * its arena, walks the heap when it was added without one
+     */
+    int64_t AllocatedBytes(JSRuntime* runtime);
+
+    // bytes allocated by loading module in runtime (see ModuleRegistry)
+    void RecordModule(JSRuntime* runtime, const std::string& module_name,
+                      int64_t bytes);
+
+    void WritePrometheus(std::ostream& out) const;
+
+private:
+    struct RuntimeEntry {
+        std::string name;
+        const RuntimeArena* arena = nullptr;
+        // last Sample of the arena
+        bool sampled = false;
+        ArenaStats arena_stats{};
+        // last heap walk, malloc_size is also updated by Sample
+        bool heap_sampled = false;
+        JSMemoryUsage usage{};
+        // total of all contexts which loaded the module
+        std::map<std::string, int64_t> modules;
+    };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<JSRuntime*, RuntimeEntry> m_runtimes;
+
+    RuntimeEntry& GetEntry(JSRuntime* runtime);
+    const RuntimeArena* FindArena(JSRuntime* runtime) const;
+};
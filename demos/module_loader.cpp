@@ -0,0 +1,163 @@
+#include "module_loader.hpp"
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace {
+
+struct PendingInit {
+    JSModuleInitFunc* init;
+    MemoryTelemetry* telemetry;
+    JSRuntime* runtime;
+};
+
+/* tracked modules created but not evaluated yet, by context & name. One
+ * which is never evaluated (an earlier module failed) is replaced when the
+ * context loads it again and dropped with its runtime
+ */
+using PendingKey = std::pair<JSContext*, std::string>;
+std::mutex gPendingMutex;
+std::map<PendingKey, PendingInit> gPendingInits;
+
+void AddPendingInit(JSContext* ctx, const char* name, PendingInit pending) {
+    std::lock_guard lock{gPendingMutex};
+    gPendingInits[{ctx, name}] = pending;
+}
+
+void ErasePendingInit(JSContext* ctx, const char* name) {
+    std::lock_guard lock{gPendingMutex};
+    gPendingInits.erase({ctx, name});
+}
+
+// JSRuntimeFinalizer
+void DropPendingInits(JSRuntime* runtime, void*) {
+    std::lock_guard lock{gPendingMutex};
+    std::erase_if(gPendingInits, [runtime](const auto& entry) {
+        return entry.second.runtime == runtime;
+    });
+}
+
+// exports are created when the module is evaluated, count them too
+int MeasuredInit(JSContext* ctx, JSModuleDef* module_def) {
+    JSAtom atom = JS_GetModuleName(ctx, module_def);
+    const char* name_str = JS_AtomToCString(ctx, atom);
+    JS_FreeAtom(ctx, atom);
+    if (!name_str) {
+        return -1;
+    }
+    std::string name{name_str};
+    JS_FreeCString(ctx, name_str);
+
+    PendingInit pending;
+    {
+        std::lock_guard lock{gPendingMutex};
+        auto it = gPendingInits.find({ctx, name});
+        if (it == gPendingInits.end()) {
+            JS_ThrowInternalError(ctx, "init of module '%s' not found",
+                                  name.c_str());
+            return -1;
+        }
+        pending = it->second;
+        gPendingInits.erase(it);
+    }
+
+    int64_t allocated = pending.telemetry->AllocatedBytes(pending.runtime);
+    int ret = pending.init(ctx, module_def);
+    if (ret == 0) {
+        pending.telemetry->RecordModule(
+            pending.runtime, name,
+            pending.telemetry->AllocatedBytes(pending.runtime) - allocated);
+    }
+    return ret;
+}
+
+}  // namespace
+
+void ModuleRegistry::AddNativeModule(const std::string& name,
+                                     ModuleFactory factory) {
+    m_modules[name] = std::move(factory);
+}
+
+void ModuleRegistry::AddNativeModule(const std::string& name,
+                                     JSModuleInitFunc* init,
+                                     std::vector<std::string> exports) {
+    AddNativeModule(name, [this, init, exports = std::move(exports)](
+                              JSContext* ctx, const char* name) {
+        MemoryTelemetry* telemetry = m_telemetry;
+        JSModuleDef* module_def =
+            JS_NewCModule(ctx, name, telemetry ? MeasuredInit : init);
+        if (!module_def) {
+            return module_def;
+        }
+
+        // set member in module which you want to export
+        for (const std::string& export_name : exports) {
+            if (JS_AddModuleExport(ctx, module_def, export_name.c_str()) < 0) {
+                return static_cast<JSModuleDef*>(nullptr);
+            }
+        }
+
+        if (telemetry) {
+            AddPendingInit(ctx, name, {init, telemetry, JS_GetRuntime(ctx)});
+        }
+        return module_def;
+    });
+}
+
+void ModuleRegistry::AddBytecodeModule(const std::string& name,
+                                       const uint8_t* data, size_t size) {
+    AddNativeModule(name, [data, size](JSContext* ctx, const char* name) {
+        JSValue obj = JS_ReadObject(ctx, data, size, JS_READ_OBJ_BYTECODE);
+        if (JS_IsException(obj)) {
+            return static_cast<JSModuleDef*>(nullptr);
+        }
+        if (JS_VALUE_GET_TAG(obj) != JS_TAG_MODULE) {
+            JS_FreeValue(ctx, obj);
+            JS_ThrowSyntaxError(ctx, "bytecode of '%s' is not a module", name);
+            return static_cast<JSModuleDef*>(nullptr);
+        }
+
+        // module is kept by context, like js_module_loader in quickjs-libc
+        JSModuleDef* module_def =
+            static_cast<JSModuleDef*>(JS_VALUE_GET_PTR(obj));
+        JS_FreeValue(ctx, obj);
+        return module_def;
+    });
+}
+
+void ModuleRegistry::Install(JSRuntime* runtime) {
+    // nullptr normalize function: default one resolving './xxx' paths
+    JS_SetModuleLoaderFunc(runtime, nullptr, Load, this);
+    // inits of modules never evaluated, see MeasuredInit
+    JS_AddRuntimeFinalizer(runtime, DropPendingInits, nullptr);
+}
+
+JSModuleDef* ModuleRegistry::Load(JSContext* ctx, const char* module_name,
+                                  void* opaque) {
+    auto registry = static_cast<const ModuleRegistry*>(opaque);
+    auto it = registry->m_modules.find(module_name);
+    if (it == registry->m_modules.end()) {
+        JS_ThrowReferenceError(ctx, "could not load module '%s'",
+                               module_name);
+        return nullptr;
+    }
+
+    JSRuntime* runtime = JS_GetRuntime(ctx);
+    MemoryTelemetry* telemetry = registry->m_telemetry;
+    int64_t allocated = telemetry ? telemetry->AllocatedBytes(runtime) : 0;
+
+    JSModuleDef* module_def = it->second(ctx, module_name);
+    if (module_def && telemetry) {
+        telemetry->RecordModule(runtime, module_name,
+                                telemetry->AllocatedBytes(runtime) - allocated);
+    }
+    if (!module_def) {
+        // no module to evaluate, drop an init the factory queued
+        ErasePendingInit(ctx, module_name);
+        if (!JS_HasException(ctx)) {
+            JS_ThrowReferenceError(ctx, "could not create module '%s'",
+                                   module_name);
+        }
+    }
+    return module_def;
+}
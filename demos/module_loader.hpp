@@ -0,0 +1,58 @@
+#pragma once
+
+#include "memory_telemetry.hpp"
+#include "quickjs.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* resolve `import ... from 'name'` against registered native modules and
+ * bytecode, instead of creating every module up front like demos/02 and
+ * demos/06 do. A module is only created when the first script of a context
+ * imports it, later imports reuse it (quickjs cache it per context)
+ *
+ * register all modules before Install(), the registry is read-only after
+ * that so it can be shared by many runtimes/threads
+ */
+class ModuleRegistry {
+public:
+    // create module named `name` in ctx, nullptr when failed
+    using ModuleFactory =
+        std::function<JSModuleDef*(JSContext* ctx, const char* name)>;
+
+    // like js_init_module_std/js_init_module_os/js_init_module_bjson
+    void AddNativeModule(const std::string& name, ModuleFactory factory);
+
+    /* module defined by JS_NewCModule(name, init) & JS_AddModuleExport (see
+     * BindingModule in demos/06-Module)
+     */
+    void AddNativeModule(const std::string& name, JSModuleInitFunc* init,
+                         std::vector<std::string> exports);
+
+    /* bytecode of a module compiled by qjsc -b (e.g. FindEmbeddedScript) or
+     * JS_WriteObject, data must outlive the registry
+     */
+    void AddBytecodeModule(const std::string& name, const uint8_t* data,
+                           size_t size);
+
+    /* record bytes allocated by creating each module into telemetry, and
+     * by evaluating it for modules added with an init function (that's
+     * when their exports are created). Top-level code of source/bytecode
+     * modules isn't counted. Cheap for runtimes added to telemetry with
+     * their arena, others get their heap walked per measurement
+     */
+    void TrackMemory(MemoryTelemetry* telemetry) { m_telemetry = telemetry; }
+
+    // set as module loader of runtime, registry must outlive runtime
+    void Install(JSRuntime* runtime);
+
+private:
+    std::unordered_map<std::string, ModuleFactory> m_modules;
+    MemoryTelemetry* m_telemetry = nullptr;
+
+    static JSModuleDef* Load(JSContext* ctx, const char* module_name,
+                             void* opaque);
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/* bounded lock-free multi-producer multi-consumer queue (Dmitry Vyukov's
+ * algorithm), every cell has a sequence number telling whether it is ready
+ * for push or pop, so producers/consumers only contend on one atomic each
+ */
+template <typename T>
+class MPMCQueue {
+public:
+    // capacity is rounded up to power of two
+    explicit MPMCQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        m_mask = size - 1;
+        m_cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+    // false when queue is full
+    bool TryPush(T value) {
+        size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff =
+                static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_enqueue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // false when queue is empty
+    bool TryPop(T& value) {
+        size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff =
+                static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (m_dequeue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->data);
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask;
+    // avoid false sharing between producers and consumers
+    alignas(64) std::atomic<size_t> m_enqueue_pos{0};
+    alignas(64) std::atomic<size_t> m_dequeue_pos{0};
+};
@@ -0,0 +1,407 @@
+#include "native_profiler.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace detail {
+
+thread_local constinit ProfileCache tProfileCache;
+thread_local constinit int tProfileDepth = 0;
+thread_local constinit int tProfileOwner = 0;
+std::atomic<uint64_t> gProfileGeneration{0};
+std::atomic<int> gProfiledRuntimeCount{0};
+
+}  // namespace detail
+
+namespace {
+
+constexpr uint32_t MaxNodes = 4096;
+constexpr int MaxDepth = 128;
+constexpr uint32_t NoNode = UINT32_MAX;
+
+/* one node per distinct native stack, node 0 is the root. Only the owner
+ * thread writes, counters are atomic so reports can read them meanwhile
+ */
+struct ProfileNode {
+    uint32_t parent = NoNode;
+    uint32_t site = 0;
+    // owner thread only
+    uint32_t first_child = NoNode;
+    uint32_t next_sibling = NoNode;
+
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> total_ticks{0};
+    std::atomic<uint64_t> self_ticks{0};
+    std::atomic<uint64_t> convert_ticks{0};
+};
+
+struct ThreadProfile {
+    std::unique_ptr<ProfileNode[]> nodes{new ProfileNode[MaxNodes]};
+    // nodes below it are initialized
+    std::atomic<uint32_t> node_count{1};
+};
+
+struct ProfileFrame {
+    uint32_t node;
+    uint64_t start;
+    uint64_t child_ticks;
+    uint64_t loaded;  // 0: arguments not loaded yet
+};
+
+// single writer, no need of atomic read-modify-write
+void Add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+}
+
+std::mutex gProfileMutex;
+std::unordered_set<JSRuntime*> gProfiledRuntimes;
+std::vector<const void*> gSiteKeys;
+std::unordered_map<const void*, std::string> gSiteNames;
+// kept after their threads exit, so reports still cover them
+std::vector<std::unique_ptr<ThreadProfile>> gThreadProfiles;
+
+// ticks <-> time, measured over the whole profiling period
+uint64_t gStartTicks;
+std::chrono::steady_clock::time_point gStartTime;
+
+thread_local ThreadProfile* tThreadProfile = nullptr;
+thread_local ProfileFrame tFrames[MaxDepth];
+
+ThreadProfile* GetThreadProfile() {
+    if (!tThreadProfile) {
+        auto profile = std::make_unique<ThreadProfile>();
+        tThreadProfile = profile.get();
+
+        std::lock_guard lock{gProfileMutex};
+        gThreadProfiles.push_back(std::move(profile));
+    }
+    return tThreadProfile;
+}
+
+uint32_t FindChild(ThreadProfile& profile, uint32_t parent, uint32_t site) {
+    ProfileNode* nodes = profile.nodes.get();
+    uint32_t* link = &nodes[parent].first_child;
+    while (*link != NoNode) {
+        if (nodes[*link].site == site) {
+            return *link;
+        }
+        link = &nodes[*link].next_sibling;
+    }
+
+    uint32_t index = profile.node_count.load(std::memory_order_relaxed);
+    if (index == MaxNodes) {
+        return NoNode;
+    }
+    nodes[index].parent = parent;
+    nodes[index].site = site;
+    profile.node_count.store(index + 1, std::memory_order_release);
+    *link = index;
+    return index;
+}
+
+struct MagicTable {
+    JSCFunction* const* thunks;
+    size_t size;
+};
+
+// registered before main, so not a global whose constructor may run later
+std::unordered_map<const void*, MagicTable>& MagicTables() {
+    static std::unordered_map<const void*, MagicTable> tables;
+    return tables;
+}
+
+// nullptr when thunk isn't of a MagicFunctionTable
+const void* MagicProfileKey(JSCFunctionMagic* thunk, int magic) {
+    std::lock_guard lock{gProfileMutex};
+    auto it = MagicTables().find(detail::ProfileKey(thunk));
+    if (it == MagicTables().end() ||
+        static_cast<size_t>(magic) >= it->second.size) {
+        return nullptr;
+    }
+    return detail::ProfileKey(it->second.thunks[magic]);
+}
+
+// takes gProfileMutex itself, may sleep: call it before locking
+double NanosecondsPerTick() {
+    uint64_t start_ticks;
+    std::chrono::steady_clock::time_point start_time;
+    {
+        std::lock_guard lock{gProfileMutex};
+        start_ticks = gStartTicks;
+        start_time = gStartTime;
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start_time;
+    // too short to compare with the clock
+    if (elapsed < std::chrono::milliseconds{10}) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10} - elapsed);
+        elapsed = std::chrono::steady_clock::now() - start_time;
+    }
+    uint64_t ticks = detail::ReadTicks() - start_ticks;
+    auto nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+    return ticks ? static_cast<double>(nanoseconds.count()) / ticks : 1.0;
+}
+
+std::string SiteName(uint32_t site) {
+    auto it = gSiteNames.find(gSiteKeys[site]);
+    if (it != gSiteNames.end()) {
+        return it->second;
+    }
+    return "native#" + std::to_string(site);
+}
+
+// walk all nodes of all threads, gProfileMutex must be held
+template <typename Visitor>
+void VisitNodes(Visitor&& visit) {
+    for (auto& profile : gThreadProfiles) {
+        uint32_t count = profile->node_count.load(std::memory_order_acquire);
+        visit(profile->nodes.get(), count);
+    }
+}
+
+}  // namespace
+
+namespace detail {
+
+bool LookupProfiling(JSRuntime* runtime) {
+    std::lock_guard lock{gProfileMutex};
+    tProfileCache.runtime = runtime;
+    tProfileCache.generation =
+        gProfileGeneration.load(std::memory_order_acquire);
+    tProfileCache.enabled = gProfiledRuntimes.count(runtime) != 0;
+    return tProfileCache.enabled;
+}
+
+uint32_t RegisterProfileSite(const void* key) {
+    std::lock_guard lock{gProfileMutex};
+    gSiteKeys.push_back(key);
+    return static_cast<uint32_t>(gSiteKeys.size() - 1);
+}
+
+bool EnterProfileSite(uint32_t site, uint64_t start) {
+    if (tProfileDepth == MaxDepth) {
+        return false;
+    }
+
+    ThreadProfile* profile = GetThreadProfile();
+    uint32_t parent = tProfileDepth ? tFrames[tProfileDepth - 1].node : 0;
+    uint32_t node = FindChild(*profile, parent, site);
+    if (node == NoNode) {
+        return false;
+    }
+
+    tFrames[tProfileDepth++] = {node, start, 0, 0};
+    return true;
+}
+
+void LeaveProfileSite(uint64_t end) {
+    const ProfileFrame& frame = tFrames[--tProfileDepth];
+    uint64_t elapsed = end - frame.start;
+
+    ProfileNode& node = tThreadProfile->nodes[frame.node];
+    Add(node.calls, 1);
+    Add(node.total_ticks, elapsed);
+    Add(node.self_ticks, elapsed - std::min(frame.child_ticks, elapsed));
+    if (frame.loaded) {
+        Add(node.convert_ticks, frame.loaded - frame.start);
+    }
+
+    if (tProfileDepth > 0) {
+        tFrames[tProfileDepth - 1].child_ticks += elapsed;
+    }
+}
+
+bool RegisterMagicProfileSites(JSCFunctionMagic* thunk,
+                               JSCFunction* const* table, size_t size) {
+    std::lock_guard lock{gProfileMutex};
+    MagicTables()[ProfileKey(thunk)] = {table, size};
+    return true;
+}
+
+void MarkArgumentsLoaded(uint64_t now) {
+    ProfileFrame& frame = tFrames[tProfileOwner - 1];
+    if (!frame.loaded) {
+        frame.loaded = now;
+    }
+}
+
+}  // namespace detail
+
+void EnableProfiling(JSRuntime* runtime) {
+    std::lock_guard lock{gProfileMutex};
+    if (!gProfiledRuntimes.insert(runtime).second) {
+        return;
+    }
+    if (gProfiledRuntimes.size() == 1 && gThreadProfiles.empty()) {
+        gStartTicks = detail::ReadTicks();
+        gStartTime = std::chrono::steady_clock::now();
+    }
+    detail::gProfiledRuntimeCount.store(
+        static_cast<int>(gProfiledRuntimes.size()), std::memory_order_relaxed);
+    detail::gProfileGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void DisableProfiling(JSRuntime* runtime) {
+    std::lock_guard lock{gProfileMutex};
+    if (gProfiledRuntimes.erase(runtime) == 0) {
+        return;
+    }
+    detail::gProfiledRuntimeCount.store(
+        static_cast<int>(gProfiledRuntimes.size()), std::memory_order_relaxed);
+    detail::gProfileGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void NameProfileSite(const void* key, const std::string& name) {
+    std::lock_guard lock{gProfileMutex};
+    gSiteNames[key] = name;
+}
+
+void NameProfileSites(const std::string& prefix,
+                      const JSCFunctionListEntry* entries, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const JSCFunctionListEntry& entry = entries[i];
+        std::string name = prefix + entry.name;
+        if (entry.def_type == JS_DEF_CFUNC &&
+            entry.u.func.cproto == JS_CFUNC_generic_magic) {
+            // the thunk is shared, name the one magic picks from the table
+            const void* key = MagicProfileKey(
+                entry.u.func.cfunc.generic_magic, entry.magic);
+            if (key) {
+                NameProfileSite(key, name);
+            }
+        } else if (entry.def_type == JS_DEF_CFUNC) {
+            NameProfileSite(detail::ProfileKey(entry.u.func.cfunc.generic),
+                            name);
+        } else if (entry.def_type == JS_DEF_CGETSET) {
+            if (entry.u.getset.get.getter) {
+                NameProfileSite(detail::ProfileKey(entry.u.getset.get.getter),
+                                name + " (get)");
+            }
+            if (entry.u.getset.set.setter) {
+                NameProfileSite(detail::ProfileKey(entry.u.getset.set.setter),
+                                name + " (set)");
+            }
+        }
+    }
+}
+
+std::vector<ProfileEntry> CollectProfile() {
+    double ns_per_tick = NanosecondsPerTick();
+    std::lock_guard lock{gProfileMutex};
+    auto to_time = [ns_per_tick](uint64_t ticks) {
+        return std::chrono::nanoseconds{
+            static_cast<int64_t>(static_cast<double>(ticks) * ns_per_tick)};
+    };
+
+    std::vector<ProfileEntry> entries(gSiteKeys.size());
+    VisitNodes([&](const ProfileNode* nodes, uint32_t count) {
+        for (uint32_t i = 1; i < count; i++) {
+            const ProfileNode& node = nodes[i];
+            ProfileEntry& entry = entries[node.site];
+            entry.calls += node.calls.load(std::memory_order_relaxed);
+            entry.self_time +=
+                to_time(node.self_ticks.load(std::memory_order_relaxed));
+            entry.convert_time +=
+                to_time(node.convert_ticks.load(std::memory_order_relaxed));
+
+            // recursion: only the outermost call count in total
+            bool nested = false;
+            for (uint32_t p = node.parent; p != 0 && !nested;
+                 p = nodes[p].parent) {
+                nested = nodes[p].site == node.site;
+            }
+            if (!nested) {
+                entry.total_time +=
+                    to_time(node.total_ticks.load(std::memory_order_relaxed));
+            }
+        }
+    });
+
+    for (uint32_t site = 0; site < entries.size(); site++) {
+        entries[site].name = SiteName(site);
+    }
+    std::erase_if(entries,
+                  [](const ProfileEntry& entry) { return entry.calls == 0; });
+    std::sort(entries.begin(), entries.end(),
+              [](const ProfileEntry& a, const ProfileEntry& b) {
+                  return a.self_time > b.self_time;
+              });
+    return entries;
+}
+
+void WriteProfileReport(std::ostream& out) {
+    auto to_ms = [](std::chrono::nanoseconds time) {
+        return std::chrono::duration<double, std::milli>(time).count();
+    };
+
+    std::vector<ProfileEntry> entries = CollectProfile();
+    out << std::setw(12) << "calls" << std::setw(12) << "total ms"
+        << std::setw(12) << "self ms" << std::setw(12) << "convert ms"
+        << std::setw(14) << "self ns/call" << "  name\n";
+    out << std::fixed << std::setprecision(3);
+    for (const ProfileEntry& entry : entries) {
+        out << std::setw(12) << entry.calls << std::setw(12)
+            << to_ms(entry.total_time) << std::setw(12)
+            << to_ms(entry.self_time) << std::setw(12)
+            << to_ms(entry.convert_time) << std::setw(14)
+            << static_cast<double>(entry.self_time.count()) / entry.calls
+            << "  " << entry.name << "\n";
+    }
+    out << std::defaultfloat;
+}
+
+void WriteCollapsedStacks(std::ostream& out) {
+    std::map<std::string, uint64_t> stacks;
+    double ns_per_tick = NanosecondsPerTick();
+    {
+        std::lock_guard lock{gProfileMutex};
+
+        VisitNodes([&](const ProfileNode* nodes, uint32_t count) {
+            for (uint32_t i = 1; i < count; i++) {
+                uint64_t ticks =
+                    nodes[i].self_ticks.load(std::memory_order_relaxed);
+                if (ticks == 0) {
+                    continue;
+                }
+
+                // root-most first
+                std::vector<uint32_t> path;
+                for (uint32_t n = i; n != 0; n = nodes[n].parent) {
+                    path.push_back(nodes[n].site);
+                }
+                std::string stack;
+                for (auto it = path.rbegin(); it != path.rend(); ++it) {
+                    if (!stack.empty()) {
+                        stack += ';';
+                    }
+                    stack += SiteName(*it);
+                }
+                stacks[stack] += static_cast<uint64_t>(
+                    static_cast<double>(ticks) * ns_per_tick);
+            }
+        });
+    }
+
+    for (const auto& [stack, nanoseconds] : stacks) {
+        out << stack << " " << nanoseconds << "\n";
+    }
+}
+
+void ResetProfile() {
+    std::lock_guard lock{gProfileMutex};
+    VisitNodes([](ProfileNode* nodes, uint32_t count) {
+        for (uint32_t i = 1; i < count; i++) {
+            nodes[i].calls.store(0, std::memory_order_relaxed);
+            nodes[i].total_ticks.store(0, std::memory_order_relaxed);
+            nodes[i].self_ticks.store(0, std::memory_order_relaxed);
+            nodes[i].convert_ticks.store(0, std::memory_order_relaxed);
+        }
+    });
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "quickjs.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define QJS_PROFILER_HAS_TSC 1
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define QJS_PROFILER_HAS_TSC 1
+#endif
+
+/* opt-in profiler of native functions bound by binding.hpp: call count,
+ * total & self time and time of converting arguments, per function and
+ * per native call stack (a native calling back into script which calls
+ * another native):
+ *
+ *   EnableProfiling(runtime);  // before binding, so names are recorded
+ *   ... bind & run scripts ...
+ *   WriteProfileReport(std::cout);
+ *   std::ofstream out{"native.folded"};
+ *   WriteCollapsedStacks(out);  // flamegraph.pl native.folded > native.svg
+ *
+ * thunks only test a counter when no runtime is profiled. Counters are
+ * per thread and written by their thread only, reports can be made while
+ * scripts run. Hand-written thunks can be profiled by ProfileScope too
+ */
+
+void EnableProfiling(JSRuntime* runtime);
+// call it before JS_FreeRuntime, a new runtime may get the same address
+void DisableProfiling(JSRuntime* runtime);
+
+// name a profiled thunk in reports, unnamed ones are shown as native#N
+void NameProfileSite(const void* key, const std::string& name);
+// name thunks of entries as prefix + entry name (see ClassBinder::Register)
+void NameProfileSites(const std::string& prefix,
+                      const JSCFunctionListEntry* entries, size_t count);
+
+struct ProfileEntry {
+    std::string name;
+    uint64_t calls = 0;
+    // nanoseconds, total include natives called inside, self doesn't
+    std::chrono::nanoseconds total_time{0};
+    std::chrono::nanoseconds self_time{0};
+    // JS arguments -> C++ values
+    std::chrono::nanoseconds convert_time{0};
+};
+
+// merged over threads, sorted by self time
+std::vector<ProfileEntry> CollectProfile();
+void WriteProfileReport(std::ostream& out);
+// one "outer;inner self_time_ns" line per native stack
+void WriteCollapsedStacks(std::ostream& out);
+// only exact when profiled threads are idle
+void ResetProfile();
+
+namespace detail {
+
+inline uint64_t ReadTicks() {
+#ifdef QJS_PROFILER_HAS_TSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+template <typename F>
+const void* ProfileKey(F* fn) {
+    return reinterpret_cast<const void*>(fn);
+}
+
+struct ProfileCache {
+    JSRuntime* runtime = nullptr;
+    uint64_t generation = 0;
+    bool enabled = false;
+};
+
+// last runtime checked by this thread, invalidated by Enable/Disable
+extern thread_local constinit ProfileCache tProfileCache;
+// natives being profiled on this thread
+extern thread_local constinit int tProfileDepth;
+// depth of the innermost ProfileScope's frame, 0 when it isn't profiled
+extern thread_local constinit int tProfileOwner;
+extern std::atomic<uint64_t> gProfileGeneration;
+extern std::atomic<int> gProfiledRuntimeCount;
+
+bool LookupProfiling(JSRuntime* runtime);
+
+/* entries of a MagicFunctionTable share its thunk, table maps magic to the
+ * thunk actually profiled. Called before main by the table
+ */
+bool RegisterMagicProfileSites(JSCFunctionMagic* thunk,
+                               JSCFunction* const* table, size_t size);
+
+inline bool IsProfiling(JSContext* ctx) {
+    if (gProfiledRuntimeCount.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+
+    JSRuntime* runtime = JS_GetRuntime(ctx);
+    const ProfileCache& cache = tProfileCache;
+    if (cache.runtime == runtime &&
+        cache.generation ==
+            gProfileGeneration.load(std::memory_order_acquire)) {
+        return cache.enabled;
+    }
+    return LookupProfiling(runtime);
+}
+
+uint32_t RegisterProfileSite(const void* key);
+
+// false when the call can't be recorded (stack too deep, table full)
+bool EnterProfileSite(uint32_t site, uint64_t start);
+void LeaveProfileSite(uint64_t end);
+void MarkArgumentsLoaded(uint64_t now);
+
+}  // namespace detail
+
+// profile the enclosing call of Thunk when its runtime is profiled
+template <auto Thunk>
+class ProfileScope {
+public:
+    explicit ProfileScope(JSContext* ctx) {
+        if (detail::IsProfiling(ctx)) {
+            m_active = detail::EnterProfileSite(Site(), detail::ReadTicks());
+        }
+        // inside a profiled native: own ProfileArgumentsLoaded until left
+        if (detail::tProfileDepth > 0) {
+            m_saved_owner = detail::tProfileOwner;
+            detail::tProfileOwner = m_active ? detail::tProfileDepth : 0;
+        }
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    ~ProfileScope() {
+        if (m_active) {
+            detail::LeaveProfileSite(detail::ReadTicks());
+        }
+        if (m_saved_owner >= 0) {
+            detail::tProfileOwner = m_saved_owner;
+        }
+    }
+
+private:
+    bool m_active = false;
+    int m_saved_owner = -1;
+
+    static uint32_t Site() {
+        static const uint32_t site =
+            detail::RegisterProfileSite(detail::ProfileKey(Thunk));
+        return site;
+    }
+};
+
+/* time since entering the innermost native is argument conversion, not
+ * recorded when that native isn't profiled (even if its caller is)
+ */
+inline void ProfileArgumentsLoaded() {
+    if (detail::tProfileOwner > 0) {
+        detail::MarkArgumentsLoaded(detail::ReadTicks());
+    }
+}
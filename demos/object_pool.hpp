@@ -0,0 +1,220 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+/* fixed-size slot allocator for native objects behind opaque pointers.
+ *
+ * slots are carved from contiguous chunks and recycled through a free list,
+ * so creating/destroying wrappers from script doesn't go through global heap
+ * (only once per chunk). Every thread keeps a small cache of free slots &
+ * only locks the shared list to move BatchSize slots at once, so workers
+ * creating objects in parallel rarely contend.
+ *
+ * the pool owns objects' memory, it must outlive every thread used it
+ */
+
+struct PoolStats {
+    size_t chunk_count = 0;
+    size_t capacity = 0;  // slot count of all chunks
+    size_t in_use = 0;    // living objects
+};
+
+template <typename T, size_t SlotsPerChunk = 256>
+class ObjectPool {
+public:
+    // slots moved between a thread cache & the shared free list at once
+    static constexpr size_t BatchSize = 32;
+
+    ObjectPool() = default;
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    ~ObjectPool() {
+        // cached slots of this thread point into m_chunks
+        if (tCache.owner == this) {
+            tCache.owner = nullptr;
+            tCache.head = nullptr;
+            tCache.count = 0;
+        }
+    }
+
+    template <typename... Args>
+    T* New(Args&&... args) {
+        Slot* slot = Acquire();
+        try {
+            return new (slot->storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            // T's constructor threw, give the slot back
+            Release(slot);
+            throw;
+        }
+    }
+
+    void Delete(T* obj) {
+        if (!obj) {
+            return;
+        }
+
+        obj->~T();
+        Release(reinterpret_cast<Slot*>(obj));
+    }
+
+    PoolStats Stats() const {
+        std::lock_guard lock{m_mutex};
+        PoolStats stats;
+        stats.chunk_count = m_chunks.size();
+        stats.capacity = m_chunks.size() * SlotsPerChunk;
+        stats.in_use = m_in_use.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    /* free slots of one thread. It serves the first pool the thread used,
+     * other pools of the same T go to their shared list directly. Slots are
+     * given back when the thread exits
+     */
+    struct ThreadCache {
+        ObjectPool* owner = nullptr;
+        Slot* head = nullptr;
+        size_t count = 0;
+
+        ~ThreadCache() {
+            if (owner) {
+                owner->Drain(*this, count);
+            }
+        }
+    };
+
+    static inline thread_local ThreadCache tCache;
+
+    std::vector<std::unique_ptr<Slot[]>> m_chunks;
+    Slot* m_free_list = nullptr;
+    std::atomic<size_t> m_in_use{0};
+    mutable std::mutex m_mutex;
+
+    Slot* Acquire() {
+        m_in_use.fetch_add(1, std::memory_order_relaxed);
+        ThreadCache& cache = tCache;
+        if (!cache.owner) {
+            cache.owner = this;
+        }
+        if (cache.owner != this) {
+            std::lock_guard lock{m_mutex};
+            if (!m_free_list) {
+                Grow();
+            }
+            Slot* slot = m_free_list;
+            m_free_list = slot->next;
+            return slot;
+        }
+
+        if (!cache.head) {
+            Refill(cache);
+        }
+        Slot* slot = cache.head;
+        cache.head = slot->next;
+        --cache.count;
+        return slot;
+    }
+
+    void Release(Slot* slot) {
+        m_in_use.fetch_sub(1, std::memory_order_relaxed);
+        ThreadCache& cache = tCache;
+        if (!cache.owner) {
+            cache.owner = this;
+        }
+        if (cache.owner != this) {
+            std::lock_guard lock{m_mutex};
+            slot->next = m_free_list;
+            m_free_list = slot;
+            return;
+        }
+
+        // LIFO, recently freed slot is likely still in cache
+        slot->next = cache.head;
+        cache.head = slot;
+        if (++cache.count > 2 * BatchSize) {
+            Drain(cache, BatchSize);
+        }
+    }
+
+    void Refill(ThreadCache& cache) {
+        std::lock_guard lock{m_mutex};
+        while (cache.count < BatchSize) {
+            if (!m_free_list) {
+                Grow();
+            }
+            Slot* slot = m_free_list;
+            m_free_list = slot->next;
+            slot->next = cache.head;
+            cache.head = slot;
+            ++cache.count;
+        }
+    }
+
+    // move count slots of cache back to the shared list
+    void Drain(ThreadCache& cache, size_t count) {
+        std::lock_guard lock{m_mutex};
+        for (; count > 0 && cache.head; count--) {
+            Slot* slot = cache.head;
+            cache.head = slot->next;
+            --cache.count;
+            slot->next = m_free_list;
+            m_free_list = slot;
+        }
+    }
+
+    void Grow() {
+        // new chunk's slots are linked in address order
+        auto& chunk = m_chunks.emplace_back(new Slot[SlotsPerChunk]);
+        for (size_t i = 0; i < SlotsPerChunk - 1; i++) {
+            chunk[i].next = &chunk[i + 1];
+        }
+        chunk[SlotsPerChunk - 1].next = m_free_list;
+        m_free_list = &chunk[0];
+    }
+};
+
+/* native object allocation of class bound by ClassBinder, use new/delete by
+ * default. Specialize it to select allocator per class:
+ *
+ *   template <>
+ *   struct ClassAllocator<Person> : PoolClassAllocator<Person> {};
+ */
+template <typename T>
+struct ClassAllocator {
+    template <typename... Args>
+    static T* New(Args&&... args) {
+        return new T(std::forward<Args>(args)...);
+    }
+
+    static void Delete(T* obj) { delete obj; }
+};
+
+template <typename T, size_t SlotsPerChunk = 256>
+struct PoolClassAllocator {
+    template <typename... Args>
+    static T* New(Args&&... args) {
+        return Pool().New(std::forward<Args>(args)...);
+    }
+
+    static void Delete(T* obj) { Pool().Delete(obj); }
+
+    static PoolStats Stats() { return Pool().Stats(); }
+
+    static ObjectPool<T, SlotsPerChunk>& Pool() {
+        static ObjectPool<T, SlotsPerChunk> pool;
+        return pool;
+    }
+};
@@ -0,0 +1,215 @@
+#include "runtime_pool.hpp"
+#include "atom_table.hpp"
+#include <iostream>
+#include <utility>
+
+RuntimeLease::RuntimeLease(RuntimePool* pool, JSRuntime* runtime,
+                           JSContext* ctx)
+    : m_pool{pool}, m_runtime{runtime}, m_ctx{ctx} {}
+
+RuntimeLease::RuntimeLease(RuntimeLease&& other) noexcept
+    : m_pool{std::exchange(other.m_pool, nullptr)},
+      m_runtime{std::exchange(other.m_runtime, nullptr)},
+      m_ctx{std::exchange(other.m_ctx, nullptr)} {}
+
+RuntimeLease& RuntimeLease::operator=(RuntimeLease&& other) noexcept {
+    if (this != &other) {
+        if (m_pool) {
+            m_pool->Release(m_runtime, m_ctx);
+        }
+        m_pool = std::exchange(other.m_pool, nullptr);
+        m_runtime = std::exchange(other.m_runtime, nullptr);
+        m_ctx = std::exchange(other.m_ctx, nullptr);
+    }
+    return *this;
+}
+
+RuntimeLease::~RuntimeLease() {
+    if (m_pool) {
+        m_pool->Release(m_runtime, m_ctx);
+    }
+}
+
+RuntimePool::RuntimePool(RuntimePoolOptions options)
+    : m_options{std::move(options)} {
+    m_idle.reserve(m_options.capacity);
+    for (size_t i = 0; i < m_options.capacity; i++) {
+        Entry entry;
+        if (!CreateRuntime(entry)) {
+            break;
+        }
+        m_idle.push_back(entry);
+    }
+    m_refill_thread = std::thread{&RuntimePool::RefillLoop, this};
+}
+
+RuntimePool::~RuntimePool() {
+    {
+        std::lock_guard lock{m_mutex};
+        m_stopping = true;
+    }
+    m_released_cv.notify_one();
+    m_refill_thread.join();
+
+    for (Entry entry : m_idle) {
+        DestroyRuntime(entry);
+    }
+    for (Entry entry : m_released) {
+        JS_UpdateStackTop(entry.runtime);
+        DestroyRuntime(entry);
+    }
+}
+
+RuntimeLease RuntimePool::Acquire() {
+    Entry entry{nullptr, nullptr};
+    bool recycle = false;
+    {
+        std::unique_lock lock{m_mutex};
+        // a runtime being refilled is still cheaper than a cold one
+        m_idle_cv.wait(lock, [this] {
+            return !m_idle.empty() || !m_released.empty() || !m_refilling;
+        });
+        if (!m_idle.empty()) {
+            entry = m_idle.back();
+            m_idle.pop_back();
+            m_stats.warm_acquired++;
+        } else if (!m_released.empty()) {
+            // refill thread is behind, replace the context here
+            entry = m_released.back();
+            m_released.pop_back();
+            recycle = true;
+            m_stats.warm_acquired++;
+        } else {
+            m_stats.cold_acquired++;
+        }
+    }
+
+    if (!entry.runtime) {
+        if (!CreateRuntime(entry)) {
+            return {};
+        }
+    } else if (recycle) {
+        if (!Recycle(entry)) {
+            return {};
+        }
+    } else {
+        // runtime may be used by another thread last time
+        JS_UpdateStackTop(entry.runtime);
+    }
+    return {this, entry.runtime, entry.ctx};
+}
+
+RuntimePoolStats RuntimePool::Stats() const {
+    std::lock_guard lock{m_mutex};
+    RuntimePoolStats stats = m_stats;
+    stats.idle = m_idle.size();
+    stats.recycling = m_released.size() + m_refilling;
+    return stats;
+}
+
+bool RuntimePool::CreateRuntime(Entry& entry) {
+    entry.runtime = JS_NewRuntime();
+    if (!entry.runtime) {
+        std::cerr << "init runtime failed" << std::endl;
+        return false;
+    }
+
+    if (m_options.init_runtime && !m_options.init_runtime(entry.runtime)) {
+        std::cerr << "init pooled runtime failed" << std::endl;
+        JS_FreeRuntime(entry.runtime);
+        return false;
+    }
+
+    entry.ctx = nullptr;
+    if (!InternAtoms(entry.runtime)) {
+        DestroyRuntime(entry);
+        return false;
+    }
+
+    entry.ctx = CreateContext(entry.runtime);
+    if (!entry.ctx) {
+        DestroyRuntime(entry);
+        return false;
+    }
+    return true;
+}
+
+JSContext* RuntimePool::CreateContext(JSRuntime* runtime) {
+    JSContext* ctx = JS_NewContext(runtime);
+    if (!ctx) {
+        std::cerr << "create context failed" << std::endl;
+        return nullptr;
+    }
+
+    if (m_options.init_context && !m_options.init_context(runtime, ctx)) {
+        std::cerr << "init pooled context failed" << std::endl;
+        JS_FreeContext(ctx);
+        return nullptr;
+    }
+    return ctx;
+}
+
+bool RuntimePool::Recycle(Entry& entry) {
+    // drop everything last script left in global, keep runtime
+    JS_UpdateStackTop(entry.runtime);
+    JS_FreeContext(entry.ctx);
+    JS_RunGC(entry.runtime);
+
+    entry.ctx = CreateContext(entry.runtime);
+    if (!entry.ctx) {
+        DestroyRuntime(entry);
+        return false;
+    }
+    return true;
+}
+
+void RuntimePool::DestroyRuntime(Entry entry) {
+    if (entry.ctx) {
+        JS_FreeContext(entry.ctx);
+    }
+    if (m_options.free_runtime) {
+        m_options.free_runtime(entry.runtime);
+    }
+    JS_FreeRuntime(entry.runtime);
+}
+
+void RuntimePool::Release(JSRuntime* runtime, JSContext* ctx) {
+    // only queued, the refill thread does the work
+    {
+        std::lock_guard lock{m_mutex};
+        m_released.push_back({runtime, ctx});
+    }
+    m_released_cv.notify_one();
+}
+
+void RuntimePool::RefillLoop() {
+    std::unique_lock lock{m_mutex};
+    while (true) {
+        m_released_cv.wait(
+            lock, [this] { return m_stopping || !m_released.empty(); });
+        if (m_stopping) {
+            return;
+        }
+
+        Entry entry = m_released.back();
+        m_released.pop_back();
+        // pool is full (there were cold runtimes)
+        bool keep = m_idle.size() + m_refilling < m_options.capacity;
+        m_refilling++;
+        lock.unlock();
+
+        if (!keep) {
+            JS_UpdateStackTop(entry.runtime);
+            DestroyRuntime(entry);
+        } else if (!Recycle(entry)) {
+            keep = false;
+        }
+
+        lock.lock();
+        m_refilling--;
+        if (keep) {
+            m_idle.push_back(entry);
+        }
+        m_idle_cv.notify_all();
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "quickjs.h"
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* keep fully initialized runtimes (std handlers, classes, modules...) ready,
+ * so a request only pays for running its script.
+ *
+ * a runtime given back to pool get a fresh context (globals of last script
+ * are dropped) by a background thread, so neither releasing nor acquiring
+ * pays for it. Finish async work (js_std_loop) before giving the lease back.
+ */
+
+struct RuntimePoolOptions {
+    // idle runtimes kept in pool, also the count created in constructor
+    size_t capacity = 4;
+
+    // once per runtime, e.g. js_std_init_handlers
+    std::function<bool(JSRuntime*)> init_runtime;
+    // once per context, e.g. js_std_add_helpers, BindClass, BindingModule
+    std::function<bool(JSRuntime*, JSContext*)> init_context;
+    // before JS_FreeRuntime, e.g. js_std_free_handlers
+    std::function<void(JSRuntime*)> free_runtime;
+};
+
+struct RuntimePoolStats {
+    size_t idle = 0;
+    size_t recycling = 0;      // given back, getting a fresh context
+    size_t warm_acquired = 0;  // served from pool
+    size_t cold_acquired = 0;  // pool is empty, created on demand
+};
+
+class RuntimePool;
+
+// runtime borrowed from pool, given back when destructed
+class RuntimeLease {
+public:
+    RuntimeLease() = default;
+    RuntimeLease(RuntimeLease&& other) noexcept;
+    RuntimeLease& operator=(RuntimeLease&& other) noexcept;
+    RuntimeLease(const RuntimeLease&) = delete;
+    RuntimeLease& operator=(const RuntimeLease&) = delete;
+    ~RuntimeLease();
+
+    JSRuntime* GetRuntime() const { return m_runtime; }
+
+    JSContext* GetContext() const { return m_ctx; }
+
+    explicit operator bool() const { return m_ctx != nullptr; }
+
+private:
+    friend class RuntimePool;
+
+    RuntimePool* m_pool = nullptr;
+    JSRuntime* m_runtime = nullptr;
+    JSContext* m_ctx = nullptr;
+
+    RuntimeLease(RuntimePool* pool, JSRuntime* runtime, JSContext* ctx);
+};
+
+// pool must outlive all its leases
+class RuntimePool {
+public:
+    explicit RuntimePool(RuntimePoolOptions options);
+    RuntimePool(const RuntimePool&) = delete;
+    RuntimePool& operator=(const RuntimePool&) = delete;
+    ~RuntimePool();
+
+    // thread-safe, but a lease must only be used by one thread at a time
+    RuntimeLease Acquire();
+
+    RuntimePoolStats Stats() const;
+
+private:
+    friend class RuntimeLease;
+
+    struct Entry {
+        JSRuntime* runtime;
+        JSContext* ctx;
+    };
+
+    RuntimePoolOptions m_options;
+    std::vector<Entry> m_idle;
+    // given back, context of last script not replaced yet
+    std::vector<Entry> m_released;
+    // taken from m_released by the refill thread
+    size_t m_refilling = 0;
+    RuntimePoolStats m_stats;
+    bool m_stopping = false;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_released_cv;
+    std::condition_variable m_idle_cv;
+    std::thread m_refill_thread;
+
+    bool CreateRuntime(Entry& entry);
+    JSContext* CreateContext(JSRuntime* runtime);
+    // replace context of a released runtime, false when it was destroyed
+    bool Recycle(Entry& entry);
+    void DestroyRuntime(Entry entry);
+    void Release(JSRuntime* runtime, JSContext* ctx);
+    void RefillLoop();
+};
@@ -0,0 +1,519 @@
+#include "sampling_profiler.hpp"
+#include "atom_table.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+/* one backtrace line of quickjs:
+ *   at fn (file.js:12:5)
+ *   at map (native)
+ */
+bool ParseFrame(std::string_view line, StackFrame& frame) {
+    size_t begin = line.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) {
+        return false;
+    }
+    line.remove_prefix(begin);
+    if (line.substr(0, 3) == "at ") {
+        line.remove_prefix(3);
+    }
+
+    std::string_view location = line;
+    size_t paren = line.rfind(" (");
+    if (paren != std::string_view::npos && line.back() == ')') {
+        frame.function = line.substr(0, paren);
+        location = line.substr(paren + 2, line.size() - paren - 3);
+    } else {
+        frame.function = "<anonymous>";
+    }
+
+    // file:line:column, file may contain ':' itself
+    frame.line = 0;
+    size_t column_colon = location.rfind(':');
+    size_t line_colon = column_colon == std::string_view::npos ||
+                                column_colon == 0
+                            ? std::string_view::npos
+                            : location.rfind(':', column_colon - 1);
+    if (line_colon != std::string_view::npos) {
+        frame.file = location.substr(0, line_colon);
+        std::string_view number =
+            location.substr(line_colon + 1, column_colon - line_colon - 1);
+        for (char ch : number) {
+            if (ch < '0' || ch > '9') {
+                frame.line = 0;
+                frame.file = location;
+                break;
+            }
+            frame.line = frame.line * 10 + (ch - '0');
+        }
+    } else {
+        frame.file = location;
+    }
+    return true;
+}
+
+// innermost frame first
+std::vector<StackFrame> ParseStack(const char* stack) {
+    std::vector<StackFrame> frames;
+    std::string_view rest{stack};
+    while (!rest.empty()) {
+        size_t end = rest.find('\n');
+        StackFrame frame;
+        if (ParseFrame(rest.substr(0, end), frame)) {
+            frames.push_back(std::move(frame));
+        }
+        if (end == std::string_view::npos) {
+            break;
+        }
+        rest.remove_prefix(end + 1);
+    }
+    return frames;
+}
+
+void WriteJsonString(std::ostream& out, std::string_view str) {
+    out << '"';
+    for (char ch : str) {
+        switch (ch) {
+            case '"':
+                out << "\\\"";
+                break;
+            case '\\':
+                out << "\\\\";
+                break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20) {
+                    out << "\\u" << std::hex << std::setw(4)
+                        << std::setfill('0') << static_cast<int>(ch)
+                        << std::dec << std::setfill(' ');
+                } else {
+                    out << ch;
+                }
+        }
+    }
+    out << '"';
+}
+
+// just enough protobuf encoding for profile.proto
+class ProtoBuffer {
+public:
+    void Varint(uint64_t value) {
+        while (value >= 0x80) {
+            m_data.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        m_data.push_back(static_cast<char>(value));
+    }
+
+    void Int(int field, uint64_t value) {
+        Key(field, 0);
+        Varint(value);
+    }
+
+    void Bytes(int field, std::string_view bytes) {
+        Key(field, 2);
+        Varint(bytes.size());
+        m_data.append(bytes);
+    }
+
+    void Message(int field, const ProtoBuffer& message) {
+        Bytes(field, message.m_data);
+    }
+
+    void Packed(int field, const std::vector<uint64_t>& values) {
+        ProtoBuffer packed;
+        for (uint64_t value : values) {
+            packed.Varint(value);
+        }
+        Bytes(field, packed.m_data);
+    }
+
+    const std::string& Data() const { return m_data; }
+
+private:
+    std::string m_data;
+
+    void Key(int field, int wire_type) {
+        Varint((static_cast<uint64_t>(field) << 3) | wire_type);
+    }
+};
+
+class StringTable {
+public:
+    uint64_t Intern(const std::string& str) {
+        auto [it, inserted] = m_index.try_emplace(str, m_strings.size());
+        if (inserted) {
+            m_strings.push_back(str);
+        }
+        return it->second;
+    }
+
+    const std::vector<std::string>& Strings() const { return m_strings; }
+
+private:
+    // index 0 must be ""
+    std::vector<std::string> m_strings{""};
+    std::unordered_map<std::string, uint64_t> m_index{{"", 0}};
+};
+
+// own property replaced by OverrideProperty, found: -1 none, 0 absent
+struct SavedProperty {
+    int found = -1;
+    JSPropertyDescriptor desc{};
+};
+
+void FreeDescriptor(JSContext* ctx, JSPropertyDescriptor& desc) {
+    JS_FreeValue(ctx, desc.value);
+    JS_FreeValue(ctx, desc.getter);
+    JS_FreeValue(ctx, desc.setter);
+}
+
+/* replace own obj[atom] by a data property without running a getter or
+ * setter of the script, false when failed (obj is left as is)
+ */
+bool OverrideProperty(JSContext* ctx, JSValueConst obj, JSAtom atom,
+                      JSValue value, SavedProperty& saved) {
+    saved.found = JS_GetOwnProperty(ctx, &saved.desc, obj, atom);
+    if (saved.found < 0) {
+        JS_FreeValue(ctx, value);
+        return false;
+    }
+    if (JS_DefinePropertyValue(ctx, obj, atom, value,
+                               JS_PROP_CONFIGURABLE | JS_PROP_WRITABLE) < 0) {
+        if (saved.found) {
+            FreeDescriptor(ctx, saved.desc);
+        }
+        saved.found = -1;
+        return false;
+    }
+    return true;
+}
+
+// put back what OverrideProperty replaced, delete it when it was absent
+void RestoreProperty(JSContext* ctx, JSValueConst obj, JSAtom atom,
+                     SavedProperty& saved) {
+    if (saved.found == 0) {
+        JS_DeleteProperty(ctx, obj, atom, 0);
+    } else if (saved.found > 0) {
+        JSPropertyDescriptor& desc = saved.desc;
+        int flags = (desc.flags & JS_PROP_C_W_E) | JS_PROP_HAS_CONFIGURABLE |
+                    JS_PROP_HAS_ENUMERABLE;
+        if (desc.flags & JS_PROP_GETSET) {
+            flags |= JS_PROP_HAS_GET | JS_PROP_HAS_SET;
+        } else {
+            flags |= JS_PROP_HAS_VALUE | JS_PROP_HAS_WRITABLE;
+        }
+        JS_DefineProperty(ctx, obj, atom, desc.value, desc.getter,
+                          desc.setter, flags);
+        FreeDescriptor(ctx, desc);
+    }
+    saved.found = -1;
+}
+
+// globalThis.Error when it's a plain data property, JS_UNDEFINED if not
+JSValue GetErrorConstructor(JSContext* ctx) {
+    JSValue global_var = JS_GetGlobalObject(ctx);
+    JSPropertyDescriptor desc;
+    int found = JS_GetOwnProperty(ctx, &desc, global_var, Atom<"Error">(ctx));
+    JS_FreeValue(ctx, global_var);
+    if (found <= 0) {
+        return JS_UNDEFINED;
+    }
+    JSValue error_ctor = JS_DupValue(ctx, desc.value);
+    FreeDescriptor(ctx, desc);
+    return error_ctor;
+}
+
+}  // namespace
+
+SamplingProfiler::SamplingProfiler(JSRuntime* runtime, SamplerOptions options,
+                                   ExecutionBudget* budget)
+    : m_runtime{runtime}, m_options{options}, m_budget{budget} {
+    JS_SetInterruptHandler(m_runtime, InterruptHandler, this);
+}
+
+SamplingProfiler::~SamplingProfiler() {
+    Stop();
+    if (m_budget) {
+        m_budget->InstallHandler();
+    } else {
+        JS_SetInterruptHandler(m_runtime, nullptr, nullptr);
+    }
+}
+
+bool SamplingProfiler::Start(JSContext* ctx) {
+    if (m_ctx) {
+        return true;
+    }
+
+    m_ctx = ctx;
+    {
+        std::lock_guard lock{m_mutex};
+        if (m_sample_count == 0) {
+            m_start_time = std::chrono::steady_clock::now();
+        }
+    }
+
+    m_running = true;
+    m_timer = std::thread{&SamplingProfiler::TimerLoop, this};
+    return true;
+}
+
+void SamplingProfiler::Stop() {
+    if (!m_ctx) {
+        return;
+    }
+
+    {
+        std::lock_guard lock{m_timer_mutex};
+        m_running = false;
+    }
+    m_timer_cv.notify_all();
+    m_timer.join();
+    m_sample_requested.store(false, std::memory_order_relaxed);
+    m_ctx = nullptr;
+}
+
+size_t SamplingProfiler::SampleCount() const {
+    std::lock_guard lock{m_mutex};
+    return m_sample_count;
+}
+
+void SamplingProfiler::TimerLoop() {
+    std::unique_lock lock{m_timer_mutex};
+    while (!m_timer_cv.wait_for(lock, m_options.interval,
+                                [this] { return !m_running; })) {
+        m_sample_requested.store(true, std::memory_order_relaxed);
+    }
+}
+
+void SamplingProfiler::TakeSample() {
+    JSContext* ctx = m_ctx;
+    // an exception is unwinding, don't replace it
+    if (!ctx || JS_HasException(ctx)) {
+        return;
+    }
+
+    /* depth & formatting of the backtrace are switched for this sample
+     * only, through own property descriptors: the script sees its own
+     * stackTraceLimit, and no accessor or prepareStackTrace of the script
+     * runs from the interrupt handler
+     */
+    JSValue error_ctor = GetErrorConstructor(ctx);
+    JSAtom limit_atom = Atom<"stackTraceLimit">(ctx);
+    JSAtom prepare_atom = Atom<"prepareStackTrace">(ctx);
+    SavedProperty limit;
+    SavedProperty prepare;
+    if (JS_IsObject(error_ctor) && limit_atom != JS_ATOM_NULL &&
+        prepare_atom != JS_ATOM_NULL &&
+        OverrideProperty(ctx, error_ctor, limit_atom,
+                         JS_NewInt32(ctx, m_options.max_depth), limit) &&
+        OverrideProperty(ctx, error_ctor, prepare_atom, JS_UNDEFINED,
+                         prepare)) {
+        // the backtrace is built when error is thrown
+        JS_ThrowPlainError(ctx, "sample");
+        JSValue error = JS_GetException(ctx);
+        JSValue stack = GetProperty<"stack">(ctx, error);
+        const char* str =
+            JS_IsString(stack) ? JS_ToCString(ctx, stack) : nullptr;
+        if (str) {
+            AddSample(ParseStack(str));
+            JS_FreeCString(ctx, str);
+        }
+        JS_FreeValue(ctx, stack);
+        JS_FreeValue(ctx, error);
+    }
+    RestoreProperty(ctx, error_ctor, prepare_atom, prepare);
+    RestoreProperty(ctx, error_ctor, limit_atom, limit);
+    JS_FreeValue(ctx, error_ctor);
+
+    // sampling must not change the script's behavior
+    if (JS_HasException(ctx)) {
+        JS_FreeValue(ctx, JS_GetException(ctx));
+    }
+}
+
+uint32_t SamplingProfiler::InternFrame(const StackFrame& frame) {
+    auto [it, inserted] = m_frame_index.try_emplace(
+        std::tuple{frame.function, frame.file, frame.line},
+        static_cast<uint32_t>(m_frames.size()));
+    if (inserted) {
+        m_frames.push_back(frame);
+    }
+    return it->second;
+}
+
+void SamplingProfiler::AddSample(const std::vector<StackFrame>& stack) {
+    if (stack.empty()) {
+        return;
+    }
+
+    std::lock_guard lock{m_mutex};
+    uint32_t node = 0;
+    for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+        uint32_t frame = InternFrame(*it);
+        auto found = m_nodes[node].children.find(frame);
+        if (found != m_nodes[node].children.end()) {
+            node = found->second;
+            continue;
+        }
+
+        uint32_t child = static_cast<uint32_t>(m_nodes.size());
+        m_nodes[node].children.emplace(frame, child);
+        m_nodes.push_back(Node{frame, node, 0, {}});
+        node = child;
+    }
+
+    m_nodes[node].self_samples++;
+    m_sample_count++;
+    if (m_timeline.size() < m_options.max_timeline_samples) {
+        m_timeline.push_back({std::chrono::steady_clock::now() - m_start_time,
+                              node});
+    }
+}
+
+int SamplingProfiler::InterruptHandler(JSRuntime*, void* opaque) {
+    auto profiler = static_cast<SamplingProfiler*>(opaque);
+    if (profiler->m_sample_requested.exchange(false,
+                                              std::memory_order_relaxed)) {
+        profiler->TakeSample();
+    }
+    return profiler->m_budget && profiler->m_budget->Poll() ? 1 : 0;
+}
+
+void SamplingProfiler::WriteChromeTrace(std::ostream& out) const {
+    std::lock_guard lock{m_mutex};
+
+    bool first = true;
+    auto write_event = [&](const char* phase, uint32_t node,
+                           std::chrono::nanoseconds time) {
+        const StackFrame& frame = m_frames[m_nodes[node].frame];
+        out << (first ? "\n" : ",\n") << "{\"name\":";
+        first = false;
+        WriteJsonString(out, frame.function);
+        out << ",\"cat\":\"js\",\"ph\":\"" << phase << "\",\"ts\":"
+            << std::chrono::duration<double, std::micro>(time).count()
+            << ",\"pid\":1,\"tid\":1";
+        if (phase[0] == 'B') {
+            out << ",\"args\":{\"file\":";
+            WriteJsonString(out, frame.file);
+            out << ",\"line\":" << frame.line << "}";
+        }
+        out << "}";
+    };
+
+    out << "{\"traceEvents\":[" << std::fixed << std::setprecision(3);
+    // a frame is open while consecutive samples contain it
+    std::vector<uint32_t> open;
+    std::vector<uint32_t> path;
+    for (const TimelineSample& sample : m_timeline) {
+        path.clear();
+        for (uint32_t node = sample.node; node != 0;
+             node = m_nodes[node].parent) {
+            path.push_back(node);
+        }
+        std::reverse(path.begin(), path.end());
+
+        size_t common = 0;
+        while (common < open.size() && common < path.size() &&
+               open[common] == path[common]) {
+            common++;
+        }
+        while (open.size() > common) {
+            write_event("E", open.back(), sample.time);
+            open.pop_back();
+        }
+        for (size_t i = common; i < path.size(); i++) {
+            write_event("B", path[i], sample.time);
+            open.push_back(path[i]);
+        }
+    }
+
+    // the last sample lasts one interval
+    std::chrono::nanoseconds end_time =
+        m_timeline.empty() ? std::chrono::nanoseconds{0}
+                           : m_timeline.back().time + m_options.interval;
+    while (!open.empty()) {
+        write_event("E", open.back(), end_time);
+        open.pop_back();
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n" << std::defaultfloat;
+}
+
+void SamplingProfiler::WritePprof(std::ostream& out) const {
+    std::lock_guard lock{m_mutex};
+
+    uint64_t interval_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            m_options.interval)
+            .count();
+
+    StringTable strings;
+    ProtoBuffer profile;
+    auto value_type = [&](int field, const char* type, const char* unit) {
+        ProtoBuffer message;
+        message.Int(1, strings.Intern(type));
+        message.Int(2, strings.Intern(unit));
+        profile.Message(field, message);
+    };
+    value_type(1, "samples", "count");
+    value_type(1, "cpu", "nanoseconds");
+
+    // sample: stack (leaf first) of every node hit by samples
+    for (uint32_t i = 1; i < m_nodes.size(); i++) {
+        uint64_t count = m_nodes[i].self_samples;
+        if (count == 0) {
+            continue;
+        }
+
+        std::vector<uint64_t> locations;
+        for (uint32_t node = i; node != 0; node = m_nodes[node].parent) {
+            // location id = frame index + 1
+            locations.push_back(m_nodes[node].frame + 1);
+        }
+        ProtoBuffer sample;
+        sample.Packed(1, locations);
+        sample.Packed(2, {count, count * interval_ns});
+        profile.Message(2, sample);
+    }
+
+    // function: one per name & file, location: one per frame (its line)
+    std::map<std::pair<std::string, std::string>, uint64_t> functions;
+    for (uint32_t i = 0; i < m_frames.size(); i++) {
+        const StackFrame& frame = m_frames[i];
+        auto [it, inserted] = functions.try_emplace(
+            std::pair{frame.function, frame.file}, functions.size() + 1);
+        if (inserted) {
+            ProtoBuffer function;
+            function.Int(1, it->second);
+            function.Int(2, strings.Intern(frame.function));
+            function.Int(3, strings.Intern(frame.function));
+            function.Int(4, strings.Intern(frame.file));
+            profile.Message(5, function);
+        }
+
+        ProtoBuffer line;
+        line.Int(1, it->second);
+        line.Int(2, static_cast<uint64_t>(frame.line));
+        ProtoBuffer location;
+        location.Int(1, i + 1);
+        location.Message(4, line);
+        profile.Message(4, location);
+    }
+
+    // period_type & period, read before string_table is written
+    ProtoBuffer period_type;
+    period_type.Int(1, strings.Intern("cpu"));
+    period_type.Int(2, strings.Intern("nanoseconds"));
+
+    for (const std::string& str : strings.Strings()) {
+        profile.Bytes(6, str);
+    }
+    profile.Message(11, period_type);
+    profile.Int(12, interval_ns);
+
+    out.write(profile.Data().data(),
+              static_cast<std::streamsize>(profile.Data().size()));
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "execution_budget.hpp"
+#include "quickjs.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+/* statistical profiler of scripts, no change to the scripts needed:
+ *
+ *   SamplingProfiler profiler{runtime};
+ *   profiler.Start(ctx);
+ *   ExecuteScript(ctx, "main.js", JS_EVAL_TYPE_GLOBAL);
+ *   js_std_loop(ctx);
+ *   profiler.Stop();
+ *   profiler.WritePprof(out);  // or WriteChromeTrace
+ *
+ * a timer thread asks for a sample every interval, the script thread takes
+ * it in the interrupt handler: the JS stack (function, file, line) is read
+ * from the backtrace of a thrown & caught error. quickjs polls the handler
+ * about every 10000 branches/calls, so a sample lands on the next poll
+ * after the tick and time in native code is attributed to its JS caller.
+ *
+ * the profiler owns the interrupt handler of the runtime. Pass the
+ * runtime's ExecutionBudget to keep its limits working, its handler is
+ * installed again when the profiler is destroyed
+ */
+
+struct SamplerOptions {
+    std::chrono::microseconds interval{1000};
+    // Error.stackTraceLimit while taking a sample, deeper frames are cut
+    int max_depth = 64;
+    // samples kept in order for the Chrome trace, the call tree has all
+    size_t max_timeline_samples = 100000;
+};
+
+struct StackFrame {
+    std::string function;
+    std::string file;
+    int line = 0;
+};
+
+class SamplingProfiler {
+public:
+    explicit SamplingProfiler(JSRuntime* runtime, SamplerOptions options = {},
+                              ExecutionBudget* budget = nullptr);
+    SamplingProfiler(const SamplingProfiler&) = delete;
+    SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+    ~SamplingProfiler();
+
+    /* sample scripts running in ctx's runtime until Stop(), call both in
+     * the script thread. ctx is used to take samples & must outlive Stop
+     */
+    bool Start(JSContext* ctx);
+    void Stop();
+
+    size_t SampleCount() const;
+
+    /* trace-event JSON (B/E events rebuilt from samples in order), open by
+     * chrome://tracing or ui.perfetto.dev
+     */
+    void WriteChromeTrace(std::ostream& out) const;
+    /* uncompressed profile.proto, open by `go tool pprof` (sample count &
+     * cpu time per stack)
+     */
+    void WritePprof(std::ostream& out) const;
+
+private:
+    // call tree node, 0 is the root
+    struct Node {
+        uint32_t frame = 0;
+        uint32_t parent = 0;
+        uint64_t self_samples = 0;
+        std::map<uint32_t, uint32_t> children;  // frame -> node
+    };
+
+    struct TimelineSample {
+        std::chrono::nanoseconds time;
+        uint32_t node;
+    };
+
+    JSRuntime* m_runtime;
+    SamplerOptions m_options;
+    ExecutionBudget* m_budget;
+    JSContext* m_ctx = nullptr;
+
+    std::thread m_timer;
+    std::mutex m_timer_mutex;
+    std::condition_variable m_timer_cv;
+    bool m_running = false;
+    std::atomic<bool> m_sample_requested{false};
+
+    // written by the script thread, read by Write*
+    mutable std::mutex m_mutex;
+    std::vector<StackFrame> m_frames;
+    std::map<std::tuple<std::string, std::string, int>, uint32_t>
+        m_frame_index;
+    std::vector<Node> m_nodes{1};
+    std::vector<TimelineSample> m_timeline;
+    uint64_t m_sample_count = 0;
+    std::chrono::steady_clock::time_point m_start_time;
+
+    void TimerLoop();
+    void TakeSample();
+    void AddSample(const std::vector<StackFrame>& stack);
+    uint32_t InternFrame(const StackFrame& frame);
+
+    static int InterruptHandler(JSRuntime* runtime, void* opaque);
+};
@@ -0,0 +1,330 @@
+#include "scheduler.hpp"
+#include "quickjs-libc.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <unistd.h>
+#elif !defined(_WIN32)
+#include <poll.h>
+#endif
+
+namespace {
+
+/* object carrying std::shared_ptr<Scheduler*> to setTimeout/clearTimeout
+ * as function data
+ */
+JSClassID gHandleClassID = 0;
+
+void HandleFinalizer(JSRuntime*, JSValue handle) {
+    delete static_cast<std::shared_ptr<Scheduler*>*>(
+        JS_GetOpaque(handle, gHandleClassID));
+}
+
+// sleep instead of waiting for fds, e.g. there is no epoll
+void SleepFor(int timeout_ms) {
+    if (timeout_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{timeout_ms});
+    }
+}
+
+// like browsers, longer delay is clamped
+constexpr double MaxDelayMs = std::numeric_limits<int32_t>::max();
+
+}  // namespace
+
+Scheduler::Scheduler(JSRuntime* runtime, SchedulerOptions options)
+    : m_runtime{runtime},
+      m_options{options},
+      m_self{std::make_shared<Scheduler*>(this)} {
+    JS_NewClassID(runtime, &gHandleClassID);
+    if (!JS_IsRegisteredClass(runtime, gHandleClassID)) {
+        // don't forget zero-initialize
+        JSClassDef def{};
+        def.class_name = "SchedulerHandle";
+        def.finalizer = HandleFinalizer;
+        JS_NewClass(runtime, gHandleClassID, &def);
+    }
+
+#ifdef __linux__
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll_fd < 0) {
+        // timers still work, Poll() sleeps & Watch() fails
+        std::cerr << "create epoll failed, fd watching is disabled"
+                  << std::endl;
+    }
+#endif
+}
+
+Scheduler::~Scheduler() {
+    // setTimeout/clearTimeout kept by scripts throw from now on
+    *m_self = nullptr;
+
+    for (auto& [deadline, timer] : m_timers) {
+        JS_FreeValueRT(m_runtime, timer.func);
+    }
+
+#ifdef __linux__
+    if (m_epoll_fd >= 0) {
+        close(m_epoll_fd);
+    }
+#endif
+}
+
+bool Scheduler::AddContext(JSContext* ctx) {
+    JSValue handle = JS_NewObjectClass(ctx, gHandleClassID);
+    if (JS_IsException(handle)) {
+        return false;
+    }
+    JS_SetOpaque(handle, new std::shared_ptr<Scheduler*>(m_self));
+
+    JSValue set_timeout =
+        JS_NewCFunctionData(ctx, SetTimeout, 2, 0, 1, &handle);
+    JSValue clear_timeout =
+        JS_NewCFunctionData(ctx, ClearTimeout, 1, 0, 1, &handle);
+    JS_FreeValue(ctx, handle);
+
+    JSValue global_this = JS_GetGlobalObject(ctx);
+    bool success = JS_SetPropertyStr(ctx, global_this, "setTimeout",
+                                     set_timeout) >= 0 &&
+                   JS_SetPropertyStr(ctx, global_this, "clearTimeout",
+                                     clear_timeout) >= 0;
+    JS_FreeValue(ctx, global_this);
+    return success;
+}
+
+void Scheduler::RemoveContext(JSContext* ctx) {
+    for (auto it = m_timers.begin(); it != m_timers.end();) {
+        if (it->second.ctx == ctx) {
+            JS_FreeValue(ctx, it->second.func);
+            m_timer_index.erase(it->second.id);
+            it = m_timers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool Scheduler::Watch(int fd, uint32_t events, IoCallback callback) {
+#if defined(__linux__)
+    if (m_epoll_fd < 0) {
+        std::cerr << "watch fd " << fd << " failed, no epoll" << std::endl;
+        return false;
+    }
+    epoll_event event{};
+    event.events = ((events & Readable) ? EPOLLIN : 0) |
+                   ((events & Writable) ? EPOLLOUT : 0);
+    event.data.fd = fd;
+    int op = m_watchers.count(fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(m_epoll_fd, op, fd, &event) < 0) {
+        std::cerr << "watch fd " << fd << " failed" << std::endl;
+        return false;
+    }
+#elif defined(_WIN32)
+    std::cerr << "watching fd is not supported on Windows" << std::endl;
+    return false;
+#endif
+
+    m_watchers[fd] = {events, std::move(callback)};
+    return true;
+}
+
+void Scheduler::Unwatch(int fd) {
+    if (m_watchers.erase(fd) == 0) {
+        return;
+    }
+#ifdef __linux__
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+}
+
+bool Scheduler::RunOnce() {
+    RunJobs();
+    FireTimers();
+
+    bool has_jobs = JS_IsJobPending(m_runtime);
+    if (m_stopping ||
+        (!has_jobs && m_timers.empty() && m_watchers.empty())) {
+        return false;
+    }
+
+    // don't sleep when jobs are left by the slice limits
+    int timeout_ms = -1;
+    if (has_jobs) {
+        timeout_ms = 0;
+    } else if (!m_timers.empty()) {
+        auto wait = std::chrono::ceil<std::chrono::milliseconds>(
+            m_timers.begin()->first - Clock::now());
+        timeout_ms = static_cast<int>(std::clamp<int64_t>(
+            wait.count(), 0, std::numeric_limits<int32_t>::max()));
+    }
+    Poll(timeout_ms);
+    return true;
+}
+
+void Scheduler::Run() {
+    m_stopping = false;
+    while (RunOnce()) {
+    }
+}
+
+void Scheduler::RunJobs() {
+    Clock::time_point deadline = Clock::now() + m_options.max_slice_time;
+    for (size_t i = 0; i < m_options.max_jobs_per_slice; i++) {
+        JSContext* job_ctx;
+        int result = JS_ExecutePendingJob(m_runtime, &job_ctx);
+        if (result == 0) {
+            break;
+        }
+        if (result < 0) {
+            js_std_dump_error(job_ctx);
+        }
+        if (Clock::now() >= deadline) {
+            break;
+        }
+    }
+}
+
+void Scheduler::FireTimers() {
+    // timers added by callbacks wait for next slice, even with zero delay
+    Clock::time_point now = Clock::now();
+    uint32_t id_limit = m_next_timer_id;
+
+    while (!m_timers.empty()) {
+        auto it = m_timers.begin();
+        if (it->first > now || it->second.id >= id_limit) {
+            break;
+        }
+
+        Timer timer = it->second;
+        m_timer_index.erase(timer.id);
+        m_timers.erase(it);
+
+        JSValue result =
+            JS_Call(timer.ctx, timer.func, JS_UNDEFINED, 0, nullptr);
+        if (JS_IsException(result)) {
+            js_std_dump_error(timer.ctx);
+        }
+        JS_FreeValue(timer.ctx, result);
+        JS_FreeValue(timer.ctx, timer.func);
+    }
+}
+
+void Scheduler::Poll(int timeout_ms) {
+#if defined(__linux__)
+    if (m_epoll_fd < 0) {
+        // nothing can be watched, see Watch()
+        SleepFor(timeout_ms);
+        return;
+    }
+    epoll_event events[64];
+    int count = epoll_wait(m_epoll_fd, events, std::size(events), timeout_ms);
+    for (int i = 0; i < count; i++) {
+        uint32_t ready = 0;
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            ready |= Readable;
+        }
+        if (events[i].events & EPOLLOUT) {
+            ready |= Writable;
+        }
+
+        auto it = m_watchers.find(events[i].data.fd);
+        if (it != m_watchers.end()) {
+            // copy, callback may unwatch (and destroy) itself
+            IoCallback callback = it->second.second;
+            callback(ready);
+        }
+    }
+#elif !defined(_WIN32)
+    std::vector<pollfd> fds;
+    fds.reserve(m_watchers.size());
+    for (auto& [fd, watcher] : m_watchers) {
+        short events = ((watcher.first & Readable) ? POLLIN : 0) |
+                       ((watcher.first & Writable) ? POLLOUT : 0);
+        fds.push_back({fd, events, 0});
+    }
+    if (poll(fds.data(), fds.size(), timeout_ms) <= 0) {
+        return;
+    }
+    for (const pollfd& fd : fds) {
+        uint32_t ready = 0;
+        if (fd.revents & (POLLIN | POLLHUP | POLLERR)) {
+            ready |= Readable;
+        }
+        if (fd.revents & POLLOUT) {
+            ready |= Writable;
+        }
+
+        auto it = m_watchers.find(fd.fd);
+        if (ready && it != m_watchers.end()) {
+            IoCallback callback = it->second.second;
+            callback(ready);
+        }
+    }
+#else
+    // no fd watching, only wait for timers
+    SleepFor(timeout_ms);
+#endif
+}
+
+Scheduler* Scheduler::FromHandle(JSValueConst handle) {
+    auto self = static_cast<std::shared_ptr<Scheduler*>*>(
+        JS_GetOpaque(handle, gHandleClassID));
+    return self ? **self : nullptr;
+}
+
+JSValue Scheduler::SetTimeout(JSContext* ctx, JSValueConst, int argc,
+                              JSValueConst* argv, int, JSValueConst* data) {
+    Scheduler* scheduler = FromHandle(data[0]);
+    if (!scheduler) {
+        return JS_ThrowInternalError(ctx, "setTimeout: scheduler is gone");
+    }
+
+    if (argc < 1 || !JS_IsFunction(ctx, argv[0])) {
+        return JS_ThrowTypeError(ctx, "setTimeout expect a function");
+    }
+    double delay = 0;
+    if (argc > 1 && JS_ToFloat64(ctx, &delay, argv[1]) < 0) {
+        return JS_EXCEPTION;
+    }
+    // NaN & negative delay mean 0
+    delay = delay > 0 ? std::min(delay, MaxDelayMs) : 0;
+
+    Clock::time_point deadline =
+        Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::duration<double, std::milli>(delay));
+    uint32_t id = scheduler->m_next_timer_id++;
+    auto it = scheduler->m_timers.emplace(
+        deadline, Timer{id, ctx, JS_DupValue(ctx, argv[0])});
+    scheduler->m_timer_index.emplace(id, it);
+    return JS_NewUint32(ctx, id);
+}
+
+JSValue Scheduler::ClearTimeout(JSContext* ctx, JSValueConst, int argc,
+                                JSValueConst* argv, int,
+                                JSValueConst* data) {
+    Scheduler* scheduler = FromHandle(data[0]);
+    if (!scheduler) {
+        return JS_ThrowInternalError(ctx, "clearTimeout: scheduler is gone");
+    }
+
+    uint32_t id;
+    if (argc < 1) {
+        return JS_UNDEFINED;
+    }
+    if (JS_ToUint32(ctx, &id, argv[0]) < 0) {
+        return JS_EXCEPTION;
+    }
+
+    auto it = scheduler->m_timer_index.find(id);
+    if (it != scheduler->m_timer_index.end()) {
+        JS_FreeValue(ctx, it->second->second.func);
+        scheduler->m_timers.erase(it->second);
+        scheduler->m_timer_index.erase(it);
+    }
+    return JS_UNDEFINED;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "quickjs.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+/* drive many contexts of one runtime from a single thread, instead of a
+ * blocking js_std_loop(ctx) (and a thread) per script.
+ *
+ * each RunOnce() is one slice: run a bounded number of pending jobs
+ * (promise reactions of all contexts, in FIFO order), fire expired
+ * timers, then wait for the next timer/fd readiness by epoll (poll on
+ * other POSIX, timers only on Windows). So a busy context can't starve
+ * idle ones waiting on timers or I/O.
+ *
+ * contexts get their own setTimeout/clearTimeout by AddContext(), they
+ * throw once the scheduler is destroyed. Destroy the scheduler before
+ * JS_FreeRuntime. A single long job is not split, bound it by
+ * ExecutionBudget (execution_budget.hpp)
+ */
+
+struct SchedulerOptions {
+    // pending jobs per slice
+    size_t max_jobs_per_slice = 64;
+    // stop running jobs of a slice once it took longer than this
+    std::chrono::microseconds max_slice_time{1000};
+};
+
+class Scheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Watch() events
+    static constexpr uint32_t Readable = 1 << 0;
+    static constexpr uint32_t Writable = 1 << 1;
+    // callback receive the ready events, it may Unwatch() its fd
+    using IoCallback = std::function<void(uint32_t events)>;
+
+    explicit Scheduler(JSRuntime* runtime, SchedulerOptions options = {});
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+    ~Scheduler();
+
+    // install setTimeout/clearTimeout into ctx's global
+    bool AddContext(JSContext* ctx);
+    // cancel timers of ctx, call it before JS_FreeContext
+    void RemoveContext(JSContext* ctx);
+
+    // call back when fd is ready, replace previous watching of fd
+    bool Watch(int fd, uint32_t events, IoCallback callback);
+    void Unwatch(int fd);
+
+    /* one slice, waiting at most until next timer when there is nothing to
+     * run. Return false when there is nothing left (no job, timer nor
+     * watched fd) or Stop() is called
+     */
+    bool RunOnce();
+
+    // RunOnce() until it return false
+    void Run();
+
+    // make Run() return after current slice
+    void Stop() { m_stopping = true; }
+
+private:
+    struct Timer {
+        uint32_t id;
+        JSContext* ctx;
+        JSValue func;
+    };
+
+    JSRuntime* m_runtime;
+    SchedulerOptions m_options;
+    /* shared with the handles given to setTimeout/clearTimeout (freed by
+     * their finalizer), nulled when the scheduler is destroyed
+     */
+    std::shared_ptr<Scheduler*> m_self;
+    bool m_stopping = false;
+
+    uint32_t m_next_timer_id = 1;
+    std::multimap<Clock::time_point, Timer> m_timers;
+    std::unordered_map<uint32_t, std::multimap<Clock::time_point,
+                                               Timer>::iterator>
+        m_timer_index;
+
+    std::unordered_map<int, std::pair<uint32_t, IoCallback>> m_watchers;
+    int m_epoll_fd = -1;
+
+    void RunJobs();
+    void FireTimers();
+    // wait for fd readiness, timeout_ms < 0 means forever
+    void Poll(int timeout_ms);
+
+    // scheduler of setTimeout/clearTimeout, nullptr when destroyed
+    static Scheduler* FromHandle(JSValueConst handle);
+
+    static JSValue SetTimeout(JSContext* ctx, JSValueConst this_val,
+                              int argc, JSValueConst* argv, int magic,
+                              JSValueConst* data);
+    static JSValue ClearTimeout(JSContext* ctx, JSValueConst this_val,
+                                int argc, JSValueConst* argv, int magic,
+                                JSValueConst* data);
+};
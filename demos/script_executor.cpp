@@ -0,0 +1,239 @@
+#include "script_executor.hpp"
+#include "atom_table.hpp"
+#include <iostream>
+
+namespace {
+
+std::string ToStdString(JSContext* ctx, JSValueConst value) {
+    size_t len;
+    const char* str = JS_ToCStringLen(ctx, &len, value);
+    if (!str) {
+        return {};
+    }
+    std::string result{str, len};
+    JS_FreeCString(ctx, str);
+    return result;
+}
+
+// exception message with its stack, like js_std_dump_error but to string
+std::string TakeException(JSContext* ctx) {
+    JSValue exception = JS_GetException(ctx);
+    std::string message = ToStdString(ctx, exception);
+    if (JS_IsError(ctx, exception)) {
+        JSValue stack = GetProperty<"stack">(ctx, exception);
+        if (!JS_IsUndefined(stack)) {
+            message += "\n" + ToStdString(ctx, stack);
+        }
+        JS_FreeValue(ctx, stack);
+    }
+    JS_FreeValue(ctx, exception);
+    return message;
+}
+
+}  // namespace
+
+ScriptExecutor::ScriptExecutor(ExecutorOptions options)
+    : m_options{std::move(options)} {
+    size_t worker_count = m_options.worker_count ? m_options.worker_count : 1;
+    m_workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; i++) {
+        m_workers.push_back(
+            std::make_unique<Worker>(m_options.queue_capacity));
+    }
+    // start threads after all queues exist, workers steal from each other
+    for (size_t i = 0; i < worker_count; i++) {
+        m_workers[i]->thread =
+            std::thread{&ScriptExecutor::WorkerLoop, this, i};
+    }
+}
+
+ScriptExecutor::~ScriptExecutor() {
+    {
+        std::lock_guard lock{m_sleep_mutex};
+        m_stopping = true;
+    }
+    m_sleep_cv.notify_all();
+    for (auto& worker : m_workers) {
+        worker->thread.join();
+    }
+}
+
+std::future<ScriptResult> ScriptExecutor::Submit(ScriptJob job) {
+    Task* task = new Task{std::move(job), {}};
+    std::future<ScriptResult> future = task->promise.get_future();
+
+    // count before push, so a worker never see the task with pending == 0
+    m_pending.fetch_add(1, std::memory_order_release);
+
+    // round-robin, try other workers when the queue is full
+    size_t start = m_next_worker.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0;; i++) {
+        Worker& worker = *m_workers[(start + i) % m_workers.size()];
+        if (worker.queue.TryPush(task)) {
+            break;
+        }
+        if (i % m_workers.size() == m_workers.size() - 1) {
+            // all queues are full, wait for workers
+            std::this_thread::yield();
+        }
+    }
+
+    {
+        // lock to not lose the wakeup of a worker going to sleep
+        std::lock_guard lock{m_sleep_mutex};
+    }
+    m_sleep_cv.notify_one();
+    return future;
+}
+
+void ScriptExecutor::WorkerLoop(size_t index) {
+    // runtime is created & used & freed only in this thread
+    JSRuntime* runtime = JS_NewRuntime();
+    if (!runtime) {
+        std::cerr << "init runtime failed" << std::endl;
+    } else if (m_options.init_runtime && !m_options.init_runtime(runtime)) {
+        std::cerr << "init worker runtime failed" << std::endl;
+        JS_FreeRuntime(runtime);
+        runtime = nullptr;
+    } else if (!InternAtoms(runtime)) {
+        std::cerr << "intern atoms of worker runtime failed" << std::endl;
+        if (m_options.free_runtime) {
+            m_options.free_runtime(runtime);
+        }
+        JS_FreeRuntime(runtime);
+        runtime = nullptr;
+    }
+
+    std::unique_ptr<ExecutionBudget> budget;
+    if (runtime) {
+        budget = std::make_unique<ExecutionBudget>(runtime);
+    }
+
+    for (;;) {
+        if (Task* task = TakeTask(index)) {
+            m_pending.fetch_sub(1, std::memory_order_relaxed);
+            if (runtime) {
+                task->promise.set_value(Run(runtime, *budget, task->job));
+            } else {
+                task->promise.set_value({false, "worker has no runtime"});
+            }
+            delete task;
+            continue;
+        }
+
+        std::unique_lock lock{m_sleep_mutex};
+        m_sleep_cv.wait(lock, [this] {
+            return m_pending.load(std::memory_order_acquire) > 0 ||
+                   m_stopping;
+        });
+        if (m_stopping && m_pending.load(std::memory_order_acquire) == 0) {
+            break;
+        }
+    }
+
+    if (runtime) {
+        budget.reset();
+        if (m_options.free_runtime) {
+            m_options.free_runtime(runtime);
+        }
+        JS_FreeRuntime(runtime);
+    }
+}
+
+ScriptExecutor::Task* ScriptExecutor::TakeTask(size_t index) {
+    Task* task;
+    if (m_workers[index]->queue.TryPop(task)) {
+        return task;
+    }
+
+    // own queue is empty, steal from others
+    for (size_t i = 1; i < m_workers.size(); i++) {
+        Worker& victim = *m_workers[(index + i) % m_workers.size()];
+        if (victim.queue.TryPop(task)) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+ScriptResult ScriptExecutor::Run(JSRuntime* runtime, ExecutionBudget& budget,
+                                 const ScriptJob& job) {
+    JSContext* ctx = JS_NewContext(runtime);
+    if (!ctx) {
+        return {false, "create context failed"};
+    }
+    if (m_options.init_context && !m_options.init_context(runtime, ctx)) {
+        JS_FreeContext(ctx);
+        return {false, "init context failed"};
+    }
+
+    JSValue global_this = JS_GetGlobalObject(ctx);
+    SetProperty<"input">(
+        ctx, global_this,
+        JS_NewStringLen(ctx, job.input.data(), job.input.size()));
+    JS_FreeValue(ctx, global_this);
+
+    // lifted when returned, after context is freed
+    ScopedBudget scoped_budget{budget, m_options.limits};
+
+    JSValue value;
+    if (!job.bytecode.empty()) {
+        JSValue obj = JS_ReadObject(ctx, job.bytecode.data(),
+                                    job.bytecode.size(), JS_READ_OBJ_BYTECODE);
+        value = JS_IsException(obj) ? obj : JS_EvalFunction(ctx, obj);
+    } else {
+        value = JS_Eval(ctx, job.source.data(), job.source.size(),
+                        job.filename.c_str(), job.flags);
+    }
+
+    // taken first, jobs must not run with it pending
+    bool failed = JS_IsException(value);
+    std::string error = failed ? TakeException(ctx) : std::string{};
+
+    /* run every job the script queued while its budget is armed, a job
+     * left behind would run & be charged in the next task. The first error
+     * fails the task, later ones are dropped
+     */
+    JSContext* job_ctx;
+    for (;;) {
+        int ret = JS_ExecutePendingJob(runtime, &job_ctx);
+        if (ret == 0) {
+            break;
+        }
+        if (ret < 0) {
+            std::string job_error = TakeException(job_ctx);
+            if (!failed) {
+                failed = true;
+                error = std::move(job_error);
+            }
+        }
+    }
+
+    ScriptResult result;
+    if (failed) {
+        result.output = std::move(error);
+    } else if (JS_HasException(ctx)) {
+        result.output = TakeException(ctx);
+    } else {
+        // completion value as is, a promise isn't awaited (shown as {})
+        JSValue json =
+            JS_JSONStringify(ctx, value, JS_UNDEFINED, JS_UNDEFINED);
+        if (JS_IsException(json)) {
+            result.output = TakeException(ctx);
+        } else {
+            result.success = true;
+            result.output =
+                JS_IsUndefined(json) ? "undefined" : ToStdString(ctx, json);
+        }
+        JS_FreeValue(ctx, json);
+    }
+
+    JS_FreeValue(ctx, value);
+    JS_FreeContext(ctx);
+
+    if (budget.Status() != BudgetStatus::Ok) {
+        result.output = std::string{ToString(budget.Status())} + ": " +
+                        result.output;
+    }
+    return result;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "execution_budget.hpp"
+#include "mpmc_queue.hpp"
+#include "quickjs.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* run independent scripts on a fixed set of worker threads.
+ *
+ * every worker own one JSRuntime which never leave that thread. Jobs are
+ * spread to workers' lock-free queues, a worker whose queue is empty steal
+ * from others, so a few long jobs don't hold short ones behind them.
+ */
+
+struct ScriptJob {
+    // either source or bytecode (from qjsc -b / JS_WriteObject)
+    std::string source;
+    std::vector<uint8_t> bytecode;
+    std::string filename = "<job>";
+    int flags = JS_EVAL_FLAG_STRICT;
+
+    // exposed to script as globalThis.input
+    std::string input;
+};
+
+struct ScriptResult {
+    bool success = false;
+    // JSON of script's completion value when success, exception otherwise
+    std::string output;
+};
+
+struct ExecutorOptions {
+    size_t worker_count = std::thread::hardware_concurrency();
+    size_t queue_capacity = 1024;  // per worker
+
+    // once per worker runtime, e.g. js_std_init_handlers
+    std::function<bool(JSRuntime*)> init_runtime;
+    // every job run in a fresh context, e.g. js_std_add_helpers, BindClass
+    std::function<bool(JSRuntime*, JSContext*)> init_context;
+    // before JS_FreeRuntime, e.g. js_std_free_handlers
+    std::function<void(JSRuntime*)> free_runtime;
+
+    // per job, a job exceeding it fails & the worker go on with next one
+    ExecutionLimits limits;
+};
+
+class ScriptExecutor {
+public:
+    explicit ScriptExecutor(ExecutorOptions options);
+    ScriptExecutor(const ScriptExecutor&) = delete;
+    ScriptExecutor& operator=(const ScriptExecutor&) = delete;
+    // finish all submitted jobs, then join workers
+    ~ScriptExecutor();
+
+    // thread-safe
+    std::future<ScriptResult> Submit(ScriptJob job);
+
+private:
+    struct Task {
+        ScriptJob job;
+        std::promise<ScriptResult> promise;
+    };
+
+    struct Worker {
+        MPMCQueue<Task*> queue;
+        std::thread thread;
+
+        explicit Worker(size_t capacity) : queue{capacity} {}
+    };
+
+    ExecutorOptions m_options;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<size_t> m_next_worker{0};
+    std::atomic<size_t> m_pending{0};
+    std::atomic<bool> m_stopping{false};
+
+    // only for sleeping when there is no job
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_sleep_cv;
+
+    void WorkerLoop(size_t index);
+    Task* TakeTask(size_t index);
+    ScriptResult Run(JSRuntime* runtime, ExecutionBudget& budget,
+                     const ScriptJob& job);
+};
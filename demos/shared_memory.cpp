@@ -0,0 +1,95 @@
+#include "shared_memory.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// keep data 16 bytes aligned for any element type
+struct alignas(16) SharedHeader {
+    std::atomic<int> ref_count;
+};
+
+SharedHeader* GetHeader(void* ptr) {
+    return static_cast<SharedHeader*>(ptr) - 1;
+}
+
+}  // namespace
+
+void EnableSharedArrayBuffers(JSRuntime* runtime) {
+    JSSharedArrayBufferFunctions functions{};
+    functions.sab_alloc = +[](void*, size_t size) { return SharedAlloc(size); };
+    functions.sab_free = +[](void*, void* ptr) { SharedFree(ptr); };
+    functions.sab_dup = +[](void*, void* ptr) { SharedDup(ptr); };
+    JS_SetSharedArrayBufferFunctions(runtime, &functions);
+}
+
+void* SharedAlloc(size_t size) {
+    void* memory = std::calloc(1, sizeof(SharedHeader) + size);
+    if (!memory) {
+        return nullptr;
+    }
+    auto header = new (memory) SharedHeader;
+    header->ref_count.store(1, std::memory_order_relaxed);
+    return header + 1;
+}
+
+void SharedDup(void* ptr) {
+    GetHeader(ptr)->ref_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SharedFree(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    SharedHeader* header = GetHeader(ptr);
+    // acq_rel: writes of other owners are visible before freeing
+    if (header->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        header->~SharedHeader();
+        std::free(header);
+    }
+}
+
+JSValue NewSharedArrayBuffer(JSContext* ctx, void* ptr, size_t size) {
+    SharedDup(ptr);
+    JSValue buffer = JS_NewArrayBuffer(
+        ctx, static_cast<uint8_t*>(ptr), size,
+        +[](JSRuntime*, void*, void* ptr) { SharedFree(ptr); }, nullptr,
+        true);
+    if (JS_IsException(buffer)) {
+        SharedFree(ptr);
+    }
+    return buffer;
+}
+
+SharedRegion::SharedRegion(size_t size)
+    : m_data{SharedAlloc(size)}, m_size{m_data ? size : 0} {}
+
+SharedRegion::SharedRegion(const SharedRegion& other)
+    : m_data{other.m_data}, m_size{other.m_size} {
+    if (m_data) {
+        SharedDup(m_data);
+    }
+}
+
+SharedRegion& SharedRegion::operator=(const SharedRegion& other) {
+    if (other.m_data) {
+        SharedDup(other.m_data);
+    }
+    SharedFree(m_data);
+    m_data = other.m_data;
+    m_size = other.m_size;
+    return *this;
+}
+
+SharedRegion::~SharedRegion() {
+    SharedFree(m_data);
+}
+
+JSValue SharedRegion::NewArrayBuffer(JSContext* ctx) const {
+    if (!m_data) {
+        return JS_ThrowRangeError(ctx, "shared region is not allocated");
+    }
+    return NewSharedArrayBuffer(ctx, m_data, m_size);
+}
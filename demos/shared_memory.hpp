@@ -0,0 +1,56 @@
+#pragma once
+
+#include "quickjs.h"
+#include <cstddef>
+
+/* memory of SharedArrayBuffer come from process heap with a reference
+ * count instead of the runtime's allocator, so one block can be referenced
+ * by runtimes on different threads (and by messages in flight, see
+ * value_transfer.hpp). Call it for every runtime exchanging SAB
+ */
+void EnableSharedArrayBuffers(JSRuntime* runtime);
+
+// zeroed block with reference count 1, nullptr when failed
+void* SharedAlloc(size_t size);
+// add a reference to block
+void SharedDup(void* ptr);
+// drop a reference, block is freed with the last one
+void SharedFree(void* ptr);
+
+/* SharedArrayBuffer over memory of block, in any runtime & any thread. The
+ * buffer holds a reference, so the block outlive whoever created it
+ */
+JSValue NewSharedArrayBuffer(JSContext* ctx, void* ptr, size_t size);
+
+/* native memory allocated once & seen as one SharedArrayBuffer by every
+ * runtime, e.g. counters or ring buffers updated by workers of
+ * ScriptExecutor through Atomics. C++ side should also access it atomically
+ * (std::atomic_ref)
+ */
+class SharedRegion {
+public:
+    SharedRegion() = default;
+    explicit SharedRegion(size_t size);
+    SharedRegion(const SharedRegion& other);
+    SharedRegion& operator=(const SharedRegion& other);
+    ~SharedRegion();
+
+    // false when allocation failed
+    explicit operator bool() const { return m_data != nullptr; }
+
+    void* Data() const { return m_data; }
+
+    size_t Size() const { return m_size; }
+
+    template <typename T>
+    T* As() const {
+        return static_cast<T*>(m_data);
+    }
+
+    // a new SharedArrayBuffer object over the region, JS_EXCEPTION when failed
+    JSValue NewArrayBuffer(JSContext* ctx) const;
+
+private:
+    void* m_data = nullptr;
+    size_t m_size = 0;
+};
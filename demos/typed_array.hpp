@@ -0,0 +1,214 @@
+#pragma once
+
+#include "quickjs.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+/* expose contiguous native memory to script as ArrayBuffer/TypedArray
+ * without copying, script reads and writes the C++ buffer directly (compare
+ * with NameGetter in demos/05-BindingClass, which build a new string on
+ * every access)
+ *
+ * the view only keeps its owner alive, not the storage position: don't
+ * resize/reallocate a container while script still holds a view of it.
+ *
+ * the owner reference is invisible to the GC: storing a view on its own
+ * owner (`obj.cache = obj.data`) makes a cycle which is never collected
+ */
+
+// JSTypedArrayEnum of element type, -1 when no TypedArray matches
+template <typename T>
+inline constexpr int TypedArrayType = -1;
+
+template <>
+inline constexpr int TypedArrayType<int8_t> = JS_TYPED_ARRAY_INT8;
+template <>
+inline constexpr int TypedArrayType<uint8_t> = JS_TYPED_ARRAY_UINT8;
+template <>
+inline constexpr int TypedArrayType<int16_t> = JS_TYPED_ARRAY_INT16;
+template <>
+inline constexpr int TypedArrayType<uint16_t> = JS_TYPED_ARRAY_UINT16;
+template <>
+inline constexpr int TypedArrayType<int32_t> = JS_TYPED_ARRAY_INT32;
+template <>
+inline constexpr int TypedArrayType<uint32_t> = JS_TYPED_ARRAY_UINT32;
+template <>
+inline constexpr int TypedArrayType<int64_t> = JS_TYPED_ARRAY_BIG_INT64;
+template <>
+inline constexpr int TypedArrayType<uint64_t> = JS_TYPED_ARRAY_BIG_UINT64;
+template <>
+inline constexpr int TypedArrayType<float> = JS_TYPED_ARRAY_FLOAT32;
+template <>
+inline constexpr int TypedArrayType<double> = JS_TYPED_ARRAY_FLOAT64;
+
+// "Float32Array" ... of JSTypedArrayEnum, for error messages
+inline const char* TypedArrayName(int type) {
+    switch (type) {
+        case JS_TYPED_ARRAY_UINT8C:
+            return "Uint8ClampedArray";
+        case JS_TYPED_ARRAY_INT8:
+            return "Int8Array";
+        case JS_TYPED_ARRAY_UINT8:
+            return "Uint8Array";
+        case JS_TYPED_ARRAY_INT16:
+            return "Int16Array";
+        case JS_TYPED_ARRAY_UINT16:
+            return "Uint16Array";
+        case JS_TYPED_ARRAY_INT32:
+            return "Int32Array";
+        case JS_TYPED_ARRAY_UINT32:
+            return "Uint32Array";
+        case JS_TYPED_ARRAY_BIG_INT64:
+            return "BigInt64Array";
+        case JS_TYPED_ARRAY_BIG_UINT64:
+            return "BigUint64Array";
+        case JS_TYPED_ARRAY_FLOAT16:
+            return "Float16Array";
+        case JS_TYPED_ARRAY_FLOAT32:
+            return "Float32Array";
+        case JS_TYPED_ARRAY_FLOAT64:
+            return "Float64Array";
+        default:
+            return "non-TypedArray";
+    }
+}
+
+/* ArrayBuffer over [data, data + size), owner (object holding the memory,
+ * e.g. `this` of a bound class) is kept alive until the buffer is collected.
+ * Don't let owner reference the buffer, see the cycle note above
+ */
+inline JSValue NewArrayBufferView(JSContext* ctx, void* data, size_t size,
+                                  JSValueConst owner) {
+    void* opaque = nullptr;
+    if (JS_IsObject(owner)) {
+        opaque = JS_VALUE_GET_PTR(JS_DupValue(ctx, owner));
+    }
+
+    JSValue buffer = JS_NewArrayBuffer(
+        ctx, static_cast<uint8_t*>(data), size,
+        +[](JSRuntime* rt, void* opaque, void*) {
+            // memory belongs to owner, only drop the reference
+            if (opaque) {
+                JS_FreeValueRT(rt, JS_MKPTR(JS_TAG_OBJECT, opaque));
+            }
+        },
+        opaque, false);
+    if (JS_IsException(buffer) && opaque) {
+        // free function isn't called when creation failed
+        JS_FreeValue(ctx, JS_MKPTR(JS_TAG_OBJECT, opaque));
+    }
+    return buffer;
+}
+
+namespace detail {
+
+// TypedArray of length elements over whole buffer, take buffer's ownership
+inline JSValue WrapTypedArray(JSContext* ctx, JSValue buffer, size_t length,
+                              int type) {
+    if (JS_IsException(buffer)) {
+        return buffer;
+    }
+
+    JSValue argv[] = {buffer, JS_NewInt32(ctx, 0),
+                      JS_NewInt64(ctx, static_cast<int64_t>(length))};
+    JSValue result = JS_NewTypedArray(ctx, 3, argv,
+                                      static_cast<JSTypedArrayEnum>(type));
+    JS_FreeValue(ctx, buffer);
+    return result;
+}
+
+}  // namespace detail
+
+// TypedArray over data, see NewArrayBufferView for owner
+template <typename T>
+JSValue NewTypedArrayView(JSContext* ctx, std::span<T> data,
+                          JSValueConst owner) {
+    static_assert(!std::is_const_v<T>, "TypedArray is always writable");
+    static_assert(TypedArrayType<T> >= 0, "no TypedArray for element type");
+
+    JSValue buffer =
+        NewArrayBufferView(ctx, data.data(), data.size_bytes(), owner);
+    return detail::WrapTypedArray(ctx, buffer, data.size(),
+                                  TypedArrayType<T>);
+}
+
+/* TypedArray sharing ownership of container (std::vector<float> ...), the
+ * container is released when both C++ and script drop it
+ */
+template <typename Container>
+JSValue NewOwningTypedArray(JSContext* ctx,
+                            std::shared_ptr<Container> container) {
+    using element_type = std::remove_pointer_t<decltype(std::data(
+        std::declval<Container&>()))>;
+    static_assert(TypedArrayType<element_type> >= 0,
+                  "no TypedArray for element type");
+
+    void* data = std::data(*container);
+    size_t length = std::size(*container);
+    auto holder = new std::shared_ptr<Container>(std::move(container));
+
+    JSValue buffer = JS_NewArrayBuffer(
+        ctx, static_cast<uint8_t*>(data), length * sizeof(element_type),
+        +[](JSRuntime*, void* opaque, void*) {
+            delete static_cast<std::shared_ptr<Container>*>(opaque);
+        },
+        holder, false);
+    if (JS_IsException(buffer)) {
+        // free function isn't called when creation failed
+        delete holder;
+        return buffer;
+    }
+    return detail::WrapTypedArray(ctx, buffer, length,
+                                  TypedArrayType<element_type>);
+}
+
+/* view script's TypedArray as span, return false (exception is pending)
+ * when value is not a TypedArray of T. span is valid as long as value is
+ * alive and its buffer is not detached
+ */
+template <typename T>
+bool GetTypedArraySpan(JSContext* ctx, JSValueConst value,
+                       std::span<T>& out) {
+    using element_type = std::remove_cv_t<T>;
+    static_assert(TypedArrayType<element_type> >= 0,
+                  "no TypedArray for element type");
+
+    int type = JS_GetTypedArrayType(value);
+    if (type != TypedArrayType<element_type> &&
+        !(type == JS_TYPED_ARRAY_UINT8C &&
+          TypedArrayType<element_type> == JS_TYPED_ARRAY_UINT8)) {
+        JS_ThrowTypeError(ctx, "expect %s but got %s",
+                          TypedArrayName(TypedArrayType<element_type>),
+                          TypedArrayName(type));
+        return false;
+    }
+
+    size_t offset, length, bytes_per_element;
+    JSValue buffer = JS_GetTypedArrayBuffer(ctx, value, &offset, &length,
+                                            &bytes_per_element);
+    if (JS_IsException(buffer)) {
+        return false;
+    }
+    if (length == 0) {
+        // nothing to view, an empty buffer may have no storage at all
+        JS_FreeValue(ctx, buffer);
+        out = {};
+        return true;
+    }
+
+    size_t size;
+    uint8_t* data = JS_GetArrayBuffer(ctx, &size, buffer);
+    // buffer is still referenced by value
+    JS_FreeValue(ctx, buffer);
+    if (!data) {
+        // detached, exception is thrown by JS_GetArrayBuffer
+        return false;
+    }
+
+    out = std::span<T>(reinterpret_cast<T*>(data + offset),
+                       length / sizeof(T));
+    return true;
+}
@@ -0,0 +1,126 @@
+#include "value_transfer.hpp"
+#include "shared_memory.hpp"
+#include <cstring>
+#include <mutex>
+#include <utility>
+
+namespace {
+
+constexpr int SerializeFlags = JS_WRITE_OBJ_SAB | JS_WRITE_OBJ_REFERENCE;
+constexpr int DeserializeFlags = JS_READ_OBJ_SAB | JS_READ_OBJ_REFERENCE;
+
+// recycle message buffers, so steady traffic doesn't allocate
+class BufferPool {
+public:
+    static constexpr size_t MaxPooledBuffers = 64;
+    // bigger buffers are given back to system
+    static constexpr size_t MaxPooledCapacity = 1024 * 1024;
+
+    std::vector<uint8_t> Take() {
+        std::lock_guard lock{m_mutex};
+        if (m_buffers.empty()) {
+            return {};
+        }
+        std::vector<uint8_t> buffer = std::move(m_buffers.back());
+        m_buffers.pop_back();
+        return buffer;
+    }
+
+    void Give(std::vector<uint8_t>&& buffer) {
+        if (buffer.capacity() == 0 ||
+            buffer.capacity() > MaxPooledCapacity) {
+            return;
+        }
+        buffer.clear();
+
+        std::lock_guard lock{m_mutex};
+        if (m_buffers.size() < MaxPooledBuffers) {
+            m_buffers.push_back(std::move(buffer));
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::vector<uint8_t>> m_buffers;
+};
+
+BufferPool gBufferPool;
+
+}  // namespace
+
+ValueMessage::ValueMessage(ValueMessage&& other) noexcept
+    : m_data{std::move(other.m_data)},
+      m_shared_buffers{std::move(other.m_shared_buffers)} {
+    other.m_data.clear();
+    other.m_shared_buffers.clear();
+}
+
+ValueMessage& ValueMessage::operator=(ValueMessage&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        m_data = std::move(other.m_data);
+        m_shared_buffers = std::move(other.m_shared_buffers);
+        other.m_data.clear();
+        other.m_shared_buffers.clear();
+    }
+    return *this;
+}
+
+ValueMessage::~ValueMessage() {
+    Reset();
+}
+
+void ValueMessage::Reset() {
+    for (void* ptr : m_shared_buffers) {
+        SharedFree(ptr);
+    }
+    m_shared_buffers.clear();
+    gBufferPool.Give(std::move(m_data));
+    m_data = {};
+}
+
+bool SerializeValue(JSContext* ctx, JSValueConst value, ValueMessage& message,
+                    const JSValueConst* detach, int detach_count) {
+    for (int i = 0; i < detach_count; i++) {
+        if (!JS_IsArrayBuffer(detach[i])) {
+            JS_ThrowTypeError(ctx, "only ArrayBuffer can be detached");
+            return false;
+        }
+    }
+
+    size_t size;
+    JSSABTab sab_tab{};
+    uint8_t* data = JS_WriteObject2(ctx, &size, value, SerializeFlags,
+                                    &sab_tab);
+    if (!data) {
+        return false;
+    }
+
+    message.Reset();
+    message.m_data = gBufferPool.Take();
+    message.m_data.assign(data, data + size);
+    // written by runtime's allocator, which is not usable from other threads
+    js_free(ctx, data);
+
+    // message keep SharedArrayBuffers alive until it is read & destroyed
+    message.m_shared_buffers.reserve(sab_tab.len);
+    for (size_t i = 0; i < sab_tab.len; i++) {
+        SharedDup(sab_tab.tab[i]);
+        message.m_shared_buffers.push_back(sab_tab.tab[i]);
+    }
+    js_free(ctx, sab_tab.tab);
+
+    // contents are in the message already
+    for (int i = 0; i < detach_count; i++) {
+        JS_DetachArrayBuffer(ctx, detach[i]);
+    }
+    return true;
+}
+
+JSValue DeserializeValue(JSContext* ctx, const ValueMessage& message) {
+    if (message.Empty()) {
+        return JS_ThrowTypeError(ctx, "empty message");
+    }
+    return JS_ReadObject(ctx, message.Data(), message.Size(),
+                         DeserializeFlags);
+}
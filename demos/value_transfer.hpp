@@ -0,0 +1,56 @@
+#pragma once
+
+#include "quickjs.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* move values between runtimes (e.g. workers of ScriptExecutor) without
+ * JSON: a value graph (objects, arrays, typed arrays, Map, Date, cycles...)
+ * is written once by JS_WriteObject into a pooled buffer which can go to
+ * any thread, then read by JS_ReadObject in another runtime.
+ *
+ * everything is copied except SharedArrayBuffer, which is passed by
+ * reference: both runtimes must call EnableSharedArrayBuffers()
+ * (shared_memory.hpp). A plain ArrayBuffer can't be handed over, its
+ * memory belongs to the allocator of its runtime, so put large binary data
+ * in SharedArrayBuffer to avoid copying it
+ */
+
+class ValueMessage {
+public:
+    ValueMessage() = default;
+    ValueMessage(ValueMessage&& other) noexcept;
+    ValueMessage& operator=(ValueMessage&& other) noexcept;
+    ValueMessage(const ValueMessage&) = delete;
+    ValueMessage& operator=(const ValueMessage&) = delete;
+    // give buffer back to pool, drop references of SharedArrayBuffers
+    ~ValueMessage();
+
+    const uint8_t* Data() const { return m_data.data(); }
+
+    size_t Size() const { return m_data.size(); }
+
+    bool Empty() const { return m_data.empty(); }
+
+private:
+    friend bool SerializeValue(JSContext*, JSValueConst, ValueMessage&,
+                               const JSValueConst*, int);
+
+    std::vector<uint8_t> m_data;
+    std::vector<void*> m_shared_buffers;
+
+    void Reset();
+};
+
+/* write value into message, return false when failed (exception pending).
+ * ArrayBuffers in detach are copied like the rest, then detached so the
+ * sender can't use them anymore (ownership semantics of postMessage's
+ * transfer list, but NOT zero-copy)
+ */
+bool SerializeValue(JSContext* ctx, JSValueConst value, ValueMessage& message,
+                    const JSValueConst* detach = nullptr,
+                    int detach_count = 0);
+
+// create value in ctx from message, JS_EXCEPTION when failed
+JSValue DeserializeValue(JSContext* ctx, const ValueMessage& message);